@@ -0,0 +1,231 @@
+#include "Analysis.h"
+#include "Bounds.h"
+#include "Writer.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace DifBuilderLib
+{
+	namespace
+	{
+		const size_t DiskHullSurfaceIndexSize = 4;
+		const size_t DiskPolyListPlaneIndexSize = 2;
+		const size_t DiskPolyListPointIndexSize = 4;
+
+		double ratio(double count, double total)
+		{
+			return total > 0.0 ? count / total : 0.0;
+		}
+
+		double volume(const Bounds &bounds)
+		{
+			if (bounds.empty())
+				return 0.0;
+			glm::vec3 d = bounds.max - bounds.min;
+			return (double)d.x * d.y * d.z;
+		}
+
+		// Plane count of every hull, hulls take the hullPlaneIndex entries up to the next hull's planeStart
+		std::vector<U32> hullPlaneCounts(const DIF::Interior &interior)
+		{
+			std::vector<U32> starts;
+			starts.reserve(interior.convexHull.size() + 1);
+			for (const DIF::Interior::ConvexHull &hull : interior.convexHull)
+				starts.push_back(hull.planeStart);
+			starts.push_back((U32)interior.hullPlaneIndex.size());
+			std::sort(starts.begin(), starts.end());
+
+			std::vector<U32> counts;
+			counts.reserve(interior.convexHull.size());
+			for (const DIF::Interior::ConvexHull &hull : interior.convexHull)
+			{
+				U32 next = *std::upper_bound(starts.begin(), starts.end() - 1, hull.planeStart);
+				counts.push_back(next > hull.planeStart ? next - hull.planeStart : 0);
+			}
+			return counts;
+		}
+
+		struct Accumulator
+		{
+			AnalysisReport &report;
+			unsigned long long leaves = 0;
+			unsigned long long leafDepthSum = 0;
+			unsigned long long solidLeafSurfaceSum = 0;
+			unsigned long long solidLeafCount = 0;
+			unsigned long long hullPlaneSum = 0;
+			unsigned long long hullPointSum = 0;
+			unsigned long long planeReferences = 0;
+			unsigned long long pointReferences = 0;
+			bool collisionDone = false;
+
+			explicit Accumulator(AnalysisReport &report) : report(report)
+			{
+				memset(&report, 0, sizeof(report));
+			}
+
+			void addLeaf(int depth, bool solid)
+			{
+				leaves++;
+				leafDepthSum += depth;
+				report.bspMaxDepth = std::max(report.bspMaxDepth, depth);
+				if (solid)
+					report.bspSolidLeaves++;
+				else
+					report.bspEmptyLeaves++;
+			}
+
+			// Returns the average leaf depth of this interior's tree
+			double walkBSP(const DIF::Interior &interior)
+			{
+				if (interior.bspNode.empty())
+					return 0.0;
+
+				unsigned long long firstLeaves = leaves;
+				unsigned long long firstDepthSum = leafDepthSum;
+				std::vector<bool> visited(interior.bspNode.size(), false);
+				std::vector<std::pair<U32, int>> stack(1, std::make_pair(0U, 1));
+				while (!stack.empty())
+				{
+					U32 index = stack.back().first;
+					int depth = stack.back().second;
+					stack.pop_back();
+					if (index >= visited.size() || visited[index])
+						continue;
+					visited[index] = true;
+					report.bspMaxDepth = std::max(report.bspMaxDepth, depth);
+
+					const DIF::Interior::BSPNode &node = interior.bspNode[index];
+					if (node.isFrontLeaf)
+						addLeaf(depth + 1, node.isFrontSolid);
+					else
+						stack.push_back(std::make_pair(node.frontIndex, depth + 1));
+					if (node.isBackLeaf)
+						addLeaf(depth + 1, node.isBackSolid);
+					else
+						stack.push_back(std::make_pair(node.backIndex, depth + 1));
+				}
+				return ratio((double)(leafDepthSum - firstDepthSum), (double)(leaves - firstLeaves));
+			}
+
+			void addCollision(const DIF::Interior &interior, const std::vector<U32> &planeCounts, double averageLeafDepth)
+			{
+				collisionDone = true;
+
+				Bounds bounds;
+				std::vector<Bounds> hullBounds(interior.convexHull.size());
+				for (size_t i = 0; i < interior.convexHull.size(); i++)
+				{
+					const DIF::Interior::ConvexHull &hull = interior.convexHull[i];
+					hullBounds[i].extend(glm::vec3(hull.minX, hull.minY, hull.minZ) - glm::vec3(CollisionQueryRadius));
+					hullBounds[i].extend(glm::vec3(hull.maxX, hull.maxY, hull.maxZ) + glm::vec3(CollisionQueryRadius));
+					bounds.extend(hullBounds[i]);
+				}
+				double total = volume(bounds);
+				if (total <= 0.0)
+				{
+					report.collisionPlaneTestsPerQuery = averageLeafDepth;
+					return;
+				}
+
+				double hulls = 0.0;
+				double planes = 0.0;
+				for (size_t i = 0; i < hullBounds.size(); i++)
+				{
+					double share = volume(hullBounds[i]) / total;
+					hulls += share;
+					planes += share * planeCounts[i];
+				}
+				report.collisionHullsPerQuery = hulls;
+				report.collisionPlaneTestsPerQuery = averageLeafDepth + planes;
+			}
+
+			void add(const DIF::Interior &interior)
+			{
+				report.pointBytes += interior.point.size() * DiskPointSize;
+				report.normalBytes += interior.normal.size() * DiskNormalSize;
+				report.planeBytes += interior.plane.size() * DiskPlaneSize;
+				report.texGenBytes += interior.texGenEq.size() * DiskTexGenSize;
+				report.windingBytes += interior.index.size() * DiskWindingSize;
+				report.surfaceBytes += interior.surface.size() * DiskSurfaceSize;
+				report.bspBytes += interior.bspNode.size() * DiskBSPNodeSize;
+				report.hullBytes += interior.convexHull.size() * DiskConvexHullSize + interior.hullIndex.size() * DiskHullIndexSize + interior.hullPlaneIndex.size() * DiskHullPlaneIndexSize + interior.hullSurfaceIndex.size() * DiskHullSurfaceIndexSize;
+				report.polyListBytes += interior.polyListPlaneIndex.size() * DiskPolyListPlaneIndexSize + interior.polyListPointIndex.size() * DiskPolyListPointIndexSize + interior.polyListStringCharacter.size();
+				for (const DIF::Interior::LightMap &lightMap : interior.lightMap)
+					report.lightMapBytes += lightMap.lightMap.data.size() + lightMap.lightDirMap.data.size();
+
+				report.points += (int)interior.point.size();
+				report.normals += (int)interior.normal.size();
+				report.planes += (int)interior.plane.size();
+				report.texGens += (int)interior.texGenEq.size();
+				report.surfaces += (int)interior.surface.size();
+				report.windings += (int)interior.index.size();
+				report.bspNodes += (int)interior.bspNode.size();
+				report.convexHulls += (int)interior.convexHull.size();
+
+				double averageLeafDepth = walkBSP(interior);
+
+				for (const DIF::Interior::BSPSolidLeaf &leaf : interior.bspSolidLeaf)
+				{
+					solidLeafSurfaceSum += leaf.surfaceCount;
+					report.solidLeafSurfaceMax = std::max(report.solidLeafSurfaceMax, (int)leaf.surfaceCount);
+				}
+				solidLeafCount += interior.bspSolidLeaf.size();
+
+				std::vector<U32> planeCounts = hullPlaneCounts(interior);
+				for (size_t i = 0; i < interior.convexHull.size(); i++)
+				{
+					hullPlaneSum += planeCounts[i];
+					hullPointSum += interior.convexHull[i].hullCount;
+				}
+
+				planeReferences += interior.surface.size() + interior.bspNode.size() + interior.hullPlaneIndex.size();
+				pointReferences += interior.index.size() + interior.hullIndex.size();
+
+				if (!collisionDone)
+					addCollision(interior, planeCounts, averageLeafDepth);
+			}
+
+			void finish()
+			{
+				report.bspAverageLeafDepth = ratio((double)leafDepthSum, (double)leaves);
+				report.solidLeafSurfaceAverage = ratio((double)solidLeafSurfaceSum, (double)solidLeafCount);
+				report.hullPlaneAverage = ratio((double)hullPlaneSum, report.convexHulls);
+				report.hullPointAverage = ratio((double)hullPointSum, report.convexHulls);
+				report.surfacesPerPlane = ratio(report.surfaces, report.planes);
+				report.surfacesPerTexGen = ratio(report.surfaces, report.texGens);
+				report.planeReferencesPerPlane = ratio((double)planeReferences, report.planes);
+				report.pointReferencesPerPoint = ratio((double)pointReferences, report.points);
+			}
+		};
+	}
+
+	void analyzeDif(const DIF::DIF &dif, AnalysisReport &report)
+	{
+		Accumulator accumulator(report);
+		report.interiors = (int)dif.interior.size();
+		report.subObjects = (int)dif.subObject.size();
+		report.totalBytes = serializedSize(dif);
+		for (const DIF::Interior &interior : dif.interior)
+		{
+			report.interiorBytes += serializedSize(interior);
+			accumulator.add(interior);
+		}
+		for (const DIF::Interior &interior : dif.subObject)
+		{
+			report.subObjectBytes += serializedSize(interior);
+			accumulator.add(interior);
+		}
+		accumulator.finish();
+	}
+
+	void analyzeInterior(const DIF::Interior &interior, AnalysisReport &report)
+	{
+		Accumulator accumulator(report);
+		report.interiors = 1;
+		report.totalBytes = report.interiorBytes = serializedSize(interior);
+		accumulator.add(interior);
+		accumulator.finish();
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "DIFBuilder/DIFBuilder.hpp"
+
+namespace DifBuilderLib
+{
+	// Half the size of the box collision queries are assumed to sweep, hulls within it of a point count for that point
+	const float CollisionQueryRadius = 0.5f;
+
+	// Structure of a DIF, filled in by analyze_dif. Plain C layout for ctypes.
+	struct AnalysisReport
+	{
+		int interiors;
+		int subObjects;
+
+		// Bytes as written. Per array sizes are element counts times their size on disk and leave out headers.
+		unsigned long long totalBytes;
+		unsigned long long interiorBytes;
+		unsigned long long subObjectBytes;
+		unsigned long long pointBytes;
+		unsigned long long normalBytes;
+		unsigned long long planeBytes;
+		unsigned long long texGenBytes;
+		unsigned long long windingBytes;
+		unsigned long long surfaceBytes;
+		unsigned long long bspBytes;
+		unsigned long long hullBytes;
+		unsigned long long polyListBytes;
+		unsigned long long lightMapBytes;
+
+		// Totals over every interior and sub object
+		int points;
+		int normals;
+		int planes;
+		int texGens;
+		int surfaces;
+		int windings;
+		int bspNodes;
+		int bspEmptyLeaves;
+		int bspSolidLeaves;
+		int convexHulls;
+
+		// Reached walking the BSP from its root, leaves count as one level below their node
+		int bspMaxDepth;
+		double bspAverageLeafDepth;
+
+		// Surfaces per solid leaf
+		int solidLeafSurfaceMax;
+		double solidLeafSurfaceAverage;
+
+		double hullPlaneAverage;
+		double hullPointAverage;
+
+		// How often each entry is referred to, higher is more sharing
+		double surfacesPerPlane;
+		double surfacesPerTexGen;
+		double planeReferencesPerPlane; // surfaces, BSP nodes and hulls
+		double pointReferencesPerPoint; // windings and hulls
+
+		// Estimated work of a point query against the first detail level, averaged over its bounds: hulls whose box
+		// grown by CollisionQueryRadius holds the point, and plane tests for the BSP descent plus those hulls
+		double collisionHullsPerQuery;
+		double collisionPlaneTestsPerQuery;
+	};
+
+	void analyzeDif(const DIF::DIF &dif, AnalysisReport &report);
+
+	void analyzeInterior(const DIF::Interior &interior, AnalysisReport &report);
+}
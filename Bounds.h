@@ -0,0 +1,38 @@
+#pragma once
+#include "DIFBuilder/DIFBuilder.hpp"
+#include <limits>
+
+namespace DifBuilderLib
+{
+	// Axis aligned box, starts out empty
+	struct Bounds
+	{
+		glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+		void extend(const glm::vec3 &point)
+		{
+			min = glm::min(min, point);
+			max = glm::max(max, point);
+		}
+
+		void extend(const Bounds &other)
+		{
+			min = glm::min(min, other.min);
+			max = glm::max(max, other.max);
+		}
+
+		bool empty() const
+		{
+			return max.x < min.x;
+		}
+
+		float area() const
+		{
+			if (empty())
+				return 0.0f;
+			glm::vec3 d = max - min;
+			return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+		}
+	};
+}
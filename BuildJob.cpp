@@ -0,0 +1,124 @@
+#include "BuildJob.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <thread>
+
+namespace DifBuilderLib
+{
+	namespace
+	{
+		class WorkerPool
+		{
+		public:
+			explicit WorkerPool(int threads)
+			{
+				for (int i = 0; i < threads; i++)
+					std::thread([this]() { run(); }).detach();
+			}
+
+			void submit(std::function<void()> task)
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mTasks.push_back(std::move(task));
+				mReady.notify_one();
+			}
+
+		private:
+			void run()
+			{
+				for (;;)
+				{
+					std::function<void()> task;
+					{
+						std::unique_lock<std::mutex> lock(mMutex);
+						mReady.wait(lock, [this]() { return !mTasks.empty(); });
+						task = std::move(mTasks.front());
+						mTasks.pop_front();
+					}
+					task();
+				}
+			}
+
+			std::mutex mMutex;
+			std::condition_variable mReady;
+			std::deque<std::function<void()>> mTasks;
+		};
+
+		// Never destroyed, joining workers while the library unloads can deadlock
+		WorkerPool &sharedPool()
+		{
+			static WorkerPool *pool = new WorkerPool(defaultThreadCount());
+			return *pool;
+		}
+
+		int watchProgress(void *user, int phase, float fraction)
+		{
+			BuildJob *job = static_cast<BuildJob *>(user);
+			job->phase = phase;
+			job->fraction = fraction;
+			if (job->cancelled)
+				return 1;
+			return job->callerProgress == NULL ? 0 : job->callerProgress(job->callerUser, phase, fraction);
+		}
+
+		void runBuild(BuildJob *job)
+		{
+			Builder *builder = job->builder;
+			builder->progress = watchProgress;
+			builder->progressUser = job;
+
+			DIF::DIF *dif = new DIF::DIF();
+			bool ok = false;
+			try
+			{
+				ok = !job->cancelled && builder->build(*dif);
+			}
+			catch (...)
+			{
+				ok = false;
+			}
+			if (!ok)
+			{
+				delete dif;
+				dif = NULL;
+			}
+
+			builder->progress = job->callerProgress;
+			builder->progressUser = job->callerUser;
+
+			// The waiter may free the job as soon as the lock is released
+			std::lock_guard<std::mutex> lock(job->mutex);
+			job->result = dif;
+			job->done = true;
+			job->finished.notify_all();
+		}
+	}
+
+	BuildJob::BuildJob(Builder *builder) : builder(builder), callerProgress(builder->progress), callerUser(builder->progressUser), phase(BUILD_PHASE_HANDOFF), fraction(0.0f), cancelled(false), done(false)
+	{
+	}
+
+	float BuildJob::progress() const
+	{
+		if (done)
+			return 1.0f;
+		float within = std::min(std::max((float)fraction, 0.0f), 1.0f);
+		return std::min((phase + within) / BUILD_PHASE_DONE, 1.0f);
+	}
+
+	DIF::DIF *BuildJob::wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		finished.wait(lock, [this]() { return (bool)done; });
+		return result;
+	}
+
+	BuildJob *startBuild(Builder *builder)
+	{
+		BuildJob *job = new BuildJob(builder);
+		sharedPool().submit([job]() { runBuild(job); });
+		return job;
+	}
+}
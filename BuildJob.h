@@ -0,0 +1,40 @@
+#pragma once
+#include "Builder.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+namespace DifBuilderLib
+{
+	// A build queued on the shared worker pool. The builder must stay alive and untouched until the job is waited on.
+	struct BuildJob
+	{
+		Builder *builder;
+
+		// The builder's own callback, still called from the worker while the job watches progress
+		ProgressCallback callerProgress;
+		void *callerUser;
+
+		std::atomic<int> phase;
+		std::atomic<float> fraction;
+		std::atomic<bool> cancelled;
+		std::atomic<bool> done;
+
+		// NULL if the build failed or was cancelled, valid once done
+		DIF::DIF *result = NULL;
+
+		std::mutex mutex;
+		std::condition_variable finished;
+
+		explicit BuildJob(Builder *builder);
+
+		// Rough overall progress in [0, 1], each phase counts the same
+		float progress() const;
+
+		// Blocks until the build is done and hands over its result
+		DIF::DIF *wait();
+	};
+
+	// Queues a build of builder on the shared worker pool, which has a thread per core
+	BuildJob *startBuild(Builder *builder);
+}
@@ -0,0 +1,438 @@
+#include "Builder.h"
+#include "Cache.h"
+#include "Layout.h"
+#include "Surfaces.h"
+#include "Transform.h"
+#include <algorithm>
+#include <unordered_set>
+
+namespace DifBuilderLib
+{
+	namespace
+	{
+		// The geometry an interior was built from, its BSP and hulls follow from it
+		uint64_t hashInterior(const DIF::Interior &interior)
+		{
+			Hasher hasher;
+			hasher.add(interior.point.data(), interior.point.size() * sizeof(glm::vec3));
+			hasher.add(interior.normal.data(), interior.normal.size() * sizeof(glm::vec3));
+			hasher.add(interior.index.data(), interior.index.size() * sizeof(U32));
+			hasher.add(interior.texGenEq.data(), interior.texGenEq.size() * sizeof(DIF::Interior::TexGenEq));
+			for (const DIF::Interior::Plane &plane : interior.plane)
+			{
+				hasher.addValue(plane.normalIndex);
+				hasher.addValue(plane.planeDistance);
+			}
+			for (const DIF::Interior::Surface &surface : interior.surface)
+			{
+				hasher.addValue(surface.windingStart);
+				hasher.addValue(surface.windingCount);
+				hasher.addValue(surface.planeIndex);
+				hasher.addValue(surface.planeFlipped);
+				hasher.addValue(surface.textureIndex);
+				hasher.addValue(surface.texGenIndex);
+			}
+			for (const std::string &material : interior.materialName)
+				hasher.add(material);
+			return hasher.finish();
+		}
+
+		bool sameGeometry(const DIF::Interior &a, const DIF::Interior &b)
+		{
+			return a.point == b.point && a.index == b.index && a.materialName == b.materialName && a.surface.size() == b.surface.size();
+		}
+
+		void hashDictionary(Hasher &hasher, const DIF::Dictionary &dict)
+		{
+			hasher.addValue(dict.size());
+			for (const auto &kvp : dict)
+			{
+				hasher.add(kvp.first);
+				hasher.add(kvp.second);
+			}
+		}
+	}
+
+	void Builder::reserve(size_t triangleCount)
+	{
+		// A streaming builder never holds more than this
+		if (spillThreshold > 0)
+			triangleCount = std::min(triangleCount, spillThreshold);
+		triangles.reserve(triangleCount, triangleCount * 3, triangleCount * 3);
+	}
+
+	void Builder::reset()
+	{
+		builder = DIF::DIFBuilder();
+		materials.clear();
+		materialIds.clear();
+		triangles.clear();
+		spill.reset();
+		spilled.clear();
+		submittedTriangles = 0;
+		bounds = Bounds();
+		offset = glm::vec3(0.0f);
+		extraInputs = Hasher();
+		pathedInteriors.clear();
+		pathedInputs.clear();
+		triggerInputs.clear();
+		stats = BuildStats();
+	}
+
+	int Builder::registerMaterial(const std::string &name)
+	{
+		auto it = materialIds.find(name);
+		if (it != materialIds.end())
+			return it->second;
+
+		int id = (int)materials.size();
+		materials.push_back(name);
+		materialIds.emplace(name, id);
+		return id;
+	}
+
+	void Builder::addTriangle(const DIF::DIFBuilder::Triangle &tri, int material)
+	{
+		if (material < 0 || material >= (int)materials.size())
+			material = registerMaterial("NULL");
+
+		triangles.add(tri, material);
+		for (int i = 0; i < 3; i++)
+			bounds.extend(tri.points[i].vertex);
+
+		if (spillThreshold > 0 && triangles.size() >= spillThreshold)
+			spillTriangles();
+	}
+
+	void Builder::addIndexedMesh(const float *positions, int vertexCount, const float *uvs, const int *loopVertices, int loopCount, const int *loopCounts, const int *materialIds, int polyCount, const float *matrix)
+	{
+		U32 pointBase = (U32)triangles.points.size();
+		U32 uvBase = (U32)triangles.uvs.size();
+		triangles.reserve(triangles.size() + (size_t)std::max(0, loopCount - 2 * polyCount), triangles.points.size() + vertexCount, triangles.uvs.size() + loopCount);
+
+		// Face normals are taken after the transform, so they need no normal matrix
+		if (matrix != NULL)
+		{
+			triangles.points.resize(pointBase + (size_t)vertexCount);
+			transformPoints(matrixFromRows(matrix), positions, (size_t)vertexCount, triangles.points.data() + pointBase);
+		}
+		else
+		{
+			for (int i = 0; i < vertexCount; i++)
+				triangles.points.push_back(glm::vec3(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]));
+		}
+		for (int i = 0; i < loopCount; i++)
+			triangles.uvs.push_back(uvs == NULL ? glm::vec2(0.0f) : glm::vec2(uvs[i * 2], uvs[i * 2 + 1]));
+
+		int nullMaterial = -1;
+		int loopStart = 0;
+		for (int poly = 0; poly < polyCount; poly++)
+		{
+			int count = loopCounts[poly];
+			int start = loopStart;
+			loopStart += count;
+			if (count < 3 || start < 0 || loopStart > loopCount)
+				continue;
+
+			// Polygons referring to a vertex that was not passed in are dropped whole
+			bool valid = true;
+			for (int loop = start; loop < loopStart && valid; loop++)
+				valid = loopVertices[loop] >= 0 && loopVertices[loop] < vertexCount;
+			if (!valid)
+				continue;
+
+			int material = materialIds[poly];
+			if (material < 0 || material >= (int)materials.size())
+			{
+				if (nullMaterial < 0)
+					nullMaterial = registerMaterial("NULL");
+				material = nullMaterial;
+			}
+
+			// Fan around the first loop, each triangle reversed into the winding DIFBuilder expects
+			for (int k = 1; k + 1 < count; k++)
+			{
+				int loops[3] = { start + k + 1, start + k, start };
+				for (int corner = 0; corner < 3; corner++)
+				{
+					U32 point = pointBase + (U32)loopVertices[loops[corner]];
+					triangles.pointIndices.push_back(point);
+					triangles.uvIndices.push_back(uvBase + (U32)loops[corner]);
+					bounds.extend(triangles.points[point]);
+				}
+
+				size_t tri = triangles.size();
+				glm::vec3 normal = glm::cross(triangles.point(tri, 1) - triangles.point(tri, 2), triangles.point(tri, 0) - triangles.point(tri, 2));
+				float length = glm::length(normal);
+				triangles.normals.push_back(length > 0.0f ? normal / length : normal);
+				triangles.materials.push_back(material);
+			}
+		}
+
+		if (spillThreshold > 0 && triangles.size() >= spillThreshold)
+			spillTriangles();
+	}
+
+	void Builder::addPathedInterior(const DIF::Interior &interior, const std::vector<DIF::DIFBuilder::Marker> &path)
+	{
+		uint64_t key = hashInterior(interior);
+		pathedInteriors.push_back(key);
+
+		extraInputs.addValue(key);
+		extraInputs.addValue(path.size());
+		for (const DIF::DIFBuilder::Marker &marker : path)
+		{
+			extraInputs.addValue(marker.position);
+			extraInputs.addValue(marker.msToNext);
+			extraInputs.addValue(marker.smoothing);
+			extraInputs.addValue(marker.initialPathPosition);
+		}
+
+		pathedInputs.push_back(std::make_pair(interior, path));
+		builder.addPathedInterior(interior, path);
+	}
+
+	void Builder::addTrigger(const DIF::DIFBuilder::Trigger &trigger)
+	{
+		extraInputs.add(trigger.name);
+		extraInputs.add(trigger.datablock);
+		hashDictionary(extraInputs, trigger.properties);
+		extraInputs.addValue(trigger.position);
+
+		triggerInputs.push_back(trigger);
+		builder.addTrigger(trigger);
+	}
+
+	void Builder::instancePathedInteriors(DIF::DIF &dif)
+	{
+		// Relies on DIFBuilder emitting one sub object and one path follower per addPathedInterior call, in order.
+		// If the output looks any different it is left un-instanced.
+		size_t count = dif.subObject.size();
+		if (count < 2 || pathedInteriors.size() != count || pathedInputs.size() != count || dif.interiorPathFollower.size() != count)
+			return;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (dif.interiorPathFollower[i].interiorResIndex != i)
+				return;
+		}
+
+		std::unordered_map<uint64_t, U32> firstByKey;
+		std::vector<U32> remap(count);
+		std::vector<DIF::Interior> unique;
+		unique.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			auto it = firstByKey.find(pathedInteriors[i]);
+			if (it != firstByKey.end() && sameGeometry(unique[it->second], dif.subObject[i]))
+			{
+				remap[i] = it->second;
+				continue;
+			}
+
+			remap[i] = (U32)unique.size();
+			firstByKey.emplace(pathedInteriors[i], remap[i]);
+			unique.push_back(std::move(dif.subObject[i]));
+		}
+
+		dif.subObject.swap(unique);
+		if (dif.subObject.size() == count)
+			return;
+
+		for (DIF::InteriorPathFollower &follower : dif.interiorPathFollower)
+			follower.interiorResIndex = remap[follower.interiorResIndex];
+	}
+
+	glm::vec3 Builder::sharedOffset(Builder *const *builders, int count, const Bounds &extra)
+	{
+		Bounds total = extra;
+		for (int i = 0; i < count; i++)
+			total.extend(builders[i]->bounds);
+		if (total.empty())
+			return glm::vec3(50.0f);
+		return (total.max - total.min) / 2.0f + glm::vec3(50.0f);
+	}
+
+	void Builder::spillTriangles(bool release)
+	{
+		if (triangles.empty())
+			return;
+		if (spill == NULL)
+			spill = SpillFile::create(spillDir);
+		if (spill != NULL && spill->append(triangles, spilled))
+		{
+			if (release)
+				triangles.release();
+			else
+				triangles.clear();
+		}
+		else
+			spillThreshold = 0;
+	}
+
+	bool Builder::hashInputs(Hasher &hasher) const
+	{
+		hasher.addValue(CacheVersion);
+		hasher.addValue(weld);
+		hasher.addValue(optimizeLayout);
+		hasher.addValue(mergeSurfaces);
+		hasher.addValue(offset);
+		hasher.addValue(faceFlags);
+
+		hasher.addValue(materials.size());
+		for (const std::string &material : materials)
+			hasher.add(material);
+
+		bool read = forEachPage(0, [&](const TriangleStore &page, size_t, size_t)
+		{
+			page.hash(hasher);
+			return true;
+		});
+		hasher.addValue(extraInputs.finish());
+		return read;
+	}
+
+	bool Builder::cacheKey(CacheKey &key) const
+	{
+		Hasher hasher;
+		Hasher check(0xC2B2AE3D27D4EB4FULL);
+		if (!hashInputs(hasher) || !hashInputs(check))
+			return false;
+
+		key.hash = hasher.finish();
+		key.check = check.finish();
+		key.inputBytes = hasher.length;
+		key.triangles = triangleCount();
+		return true;
+	}
+
+	bool Builder::reportProgress(int phase, float fraction)
+	{
+		return progress == NULL || progress(progressUser, phase, fraction) == 0;
+	}
+
+	void Builder::countOutput(const DIF::DIF &dif)
+	{
+		stats.triangles = (int)triangleCount();
+		stats.materials = (int)materials.size();
+		stats.points = stats.normals = stats.planes = stats.texGens = 0;
+		stats.surfaces = stats.windings = stats.bspNodes = stats.convexHulls = 0;
+		stats.surfaceGroups = 0;
+		for (const DIF::Interior &interior : dif.interior)
+		{
+			stats.points += (int)interior.point.size();
+			stats.normals += (int)interior.normal.size();
+			stats.planes += (int)interior.plane.size();
+			stats.texGens += (int)interior.texGenEq.size();
+			stats.surfaces += (int)interior.surface.size();
+			stats.windings += (int)interior.index.size();
+			stats.bspNodes += (int)interior.bspNode.size();
+			stats.convexHulls += (int)interior.convexHull.size();
+
+			std::unordered_set<uint64_t> groups;
+			for (const DIF::Interior::Surface &surface : interior.surface)
+				groups.insert(((uint64_t)surface.planeIndex << 48) | ((uint64_t)surface.planeFlipped << 47) | ((uint64_t)surface.textureIndex << 31) | surface.texGenIndex);
+			stats.surfaceGroups += (int)groups.size();
+		}
+	}
+
+	bool Builder::build(DIF::DIF &dif)
+	{
+		AllocationScope allocations;
+
+		// DIFBuilder gets its own copy of every triangle, so a streaming builder moves the rest of its triangles to the
+		// spill file and reads them back a page at a time. Otherwise they are handed off from memory. Either way they
+		// are kept to partition the builder again if the chunk turns out too large.
+		if (spillThreshold > 0)
+			spillTriangles(true);
+
+		std::string cached;
+		CacheKey key;
+		if (!cacheDir.empty())
+		{
+			Stopwatch cacheTime;
+			if (!cacheKey(key))
+				return false;
+			cached = cachePath(cacheDir, key);
+			bool hit = loadCached(cached, key, dif);
+			stats.cacheSeconds += cacheTime.seconds();
+			if (hit)
+			{
+				stats.cacheHit = 1;
+				stats.peakAllocatedBytes = allocations.peak();
+				countOutput(dif);
+				return reportProgress(BUILD_PHASE_DONE, 1.0f);
+			}
+		}
+
+		// Report every few thousand triangles, the callback may well be a Python function
+		const size_t ReportInterval = 4096;
+		size_t total = triangleCount();
+		bool flip = (faceFlags & FACE_FLIP) != 0;
+		Stopwatch handoffTime;
+		bool handedOff = forEachPage(submittedTriangles, [&](const TriangleStore &page, size_t first, size_t count)
+		{
+			for (size_t i = first; i < first + count; i++, submittedTriangles++)
+			{
+				if (submittedTriangles % ReportInterval == 0 && !reportProgress(BUILD_PHASE_HANDOFF, (float)submittedTriangles / total))
+					return false;
+				DIF::DIFBuilder::Triangle tri = page.triangle(i);
+				for (int j = 0; j < 3; j++)
+					tri.points[j].vertex += offset;
+
+				// The reversed face keeps the submitted normal, DIFBuilder derives the plane from the winding
+				DIF::DIFBuilder::Triangle reversed = tri;
+				std::swap(reversed.points[0], reversed.points[2]);
+
+				const std::string &material = materials[page.materials[i]];
+				builder.addTriangle(flip ? reversed : tri, material);
+				if (faceFlags & FACE_DOUBLE_SIDED)
+					builder.addTriangle(flip ? tri : reversed, material);
+			}
+			return true;
+		});
+		stats.handoffSeconds += handoffTime.seconds();
+		if (!handedOff)
+			return false;
+
+		if (!reportProgress(BUILD_PHASE_BUILD, 0.0f))
+			return false;
+		Stopwatch buildTime;
+		builder.build(dif);
+		instancePathedInteriors(dif);
+		stats.buildSeconds += buildTime.seconds();
+
+		if (!reportProgress(BUILD_PHASE_WELD, 0.0f))
+			return false;
+		Stopwatch weldTime;
+		weldDif(dif, weld, (faceFlags & FACE_DOUBLE_SIDED) != 0);
+		stats.weldSeconds += weldTime.seconds();
+
+		if (mergeSurfaces)
+		{
+			Stopwatch mergeTime;
+			DifBuilderLib::mergeSurfaces(dif);
+			stats.mergeSeconds += mergeTime.seconds();
+		}
+
+		if (optimizeLayout)
+		{
+			Stopwatch layoutTime;
+			DifBuilderLib::optimizeLayout(dif);
+			stats.layoutSeconds += layoutTime.seconds();
+		}
+
+		if (!cached.empty())
+		{
+			if (!reportProgress(BUILD_PHASE_CACHE, 0.0f))
+				return false;
+			Stopwatch cacheTime;
+			storeCached(cacheDir, cached, key, dif);
+			stats.cacheSeconds += cacheTime.seconds();
+		}
+
+		stats.cacheHit = 0;
+		stats.peakAllocatedBytes = allocations.peak();
+		countOutput(dif);
+		return reportProgress(BUILD_PHASE_DONE, 1.0f);
+	}
+}
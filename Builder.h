@@ -0,0 +1,159 @@
+#pragma once
+#include "DIFBuilder/DIFBuilder.hpp"
+#include "Bounds.h"
+#include "Cache.h"
+#include "Hash.h"
+#include "Spill.h"
+#include "Stats.h"
+#include "Triangles.h"
+#include "Weld.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace DifBuilderLib
+{
+	// Builder wide face flags for set_face_mode
+	enum FaceFlags
+	{
+		// Emit every triangle with reversed winding
+		FACE_FLIP = 1,
+		// Emit every triangle in both windings, FACE_FLIP picks which one comes first. DIFBuilder gets the
+		// reversed face as a triangle of its own, nothing of the front face is reused while building. Welding the
+		// finished interior then merges each pair of opposite planes into one referred to flipped
+		FACE_DOUBLE_SIDED = 2
+	};
+
+	// Spilled triangles are read back this many at a time
+	const size_t PageTriangles = 65536;
+
+	// A DIF::DIFBuilder plus the state the C API keeps for it
+	struct Builder
+	{
+		DIF::DIFBuilder builder;
+
+		// Interned material names, triangles refer to them by index
+		std::vector<std::string> materials;
+		std::unordered_map<std::string, int> materialIds;
+
+		// Triangles are kept here unless the builder streams, then partition and build move them to the spill file
+		// and read them back from there.
+		TriangleStore triangles;
+		size_t submittedTriangles = 0;
+
+		// Streaming: once triangles holds spillThreshold triangles they move to spill, 0 keeps everything in memory.
+		// spilled lists their records in submission order, ahead of the ones still in triangles.
+		// spillDir and spillThreshold are kept across reset
+		std::string spillDir;
+		size_t spillThreshold = 0;
+		std::shared_ptr<SpillFile> spill;
+		std::vector<U32> spilled;
+
+		size_t triangleCount() const
+		{
+			return spilled.size() + triangles.size();
+		}
+
+		// Of the submitted vertices, before offset
+		Bounds bounds;
+
+		// Added to every vertex when handing the triangles to DIFBuilder
+		glm::vec3 offset = glm::vec3(0.0f);
+
+		// FaceFlags applied when handing the triangles to DIFBuilder, kept across reset
+		int faceFlags = 0;
+
+		int facesPerTriangle() const
+		{
+			return (faceFlags & FACE_DOUBLE_SIDED) ? 2 : 1;
+		}
+
+		// Applied to the built interior, kept across reset
+		WeldTolerances weld;
+		bool optimizeLayout = false;
+		bool mergeSurfaces = false;
+
+		// Directory of previously built DIFs keyed by cacheKey, empty disables caching. Kept across reset
+		std::string cacheDir;
+
+		// Pathed interiors and triggers go straight into DIFBuilder, this tracks them for the cache key
+		Hasher extraInputs;
+
+		// Geometry hash of each pathed interior in the order they were added
+		std::vector<uint64_t> pathedInteriors;
+
+		// Copies of the pathed interiors and triggers, so partition can hand them on to a chunk
+		std::vector<std::pair<DIF::Interior, std::vector<DIF::DIFBuilder::Marker>>> pathedInputs;
+		std::vector<DIF::DIFBuilder::Trigger> triggerInputs;
+
+		BuildStats stats = BuildStats();
+
+		// Kept across reset
+		ProgressCallback progress = NULL;
+		void *progressUser = NULL;
+
+		// Pre-sizes the triangle storage so submission does not reallocate
+		void reserve(size_t triangleCount);
+
+		// Drops everything submitted so far but keeps the storage capacity for the next chunk
+		void reset();
+
+		int registerMaterial(const std::string &name);
+		void addTriangle(const DIF::DIFBuilder::Triangle &tri, int material);
+
+		// Vertices, loops and polygons as Blender lays them out. uvs has 2 floats per loop and may be NULL,
+		// polygons take loopCounts[i] consecutive loops, are fan triangulated and get their face normal. Polygons with
+		// fewer than 3 loops, loops past loopCount or a vertex outside [0, vertexCount) are skipped.
+		// matrix is 16 floats, row major, applied to the positions; NULL leaves them as they are.
+		void addIndexedMesh(const float *positions, int vertexCount, const float *uvs, const int *loopVertices, int loopCount, const int *loopCounts, const int *materialIds, int polyCount, const float *matrix);
+		void addPathedInterior(const DIF::Interior &interior, const std::vector<DIF::DIFBuilder::Marker> &path);
+		void addTrigger(const DIF::DIFBuilder::Trigger &trigger);
+
+		// Moves triangles to the spill file, release also frees their storage. If that fails they stay in memory and
+		// streaming is turned off.
+		void spillTriangles(bool release = false);
+
+		// Calls fn(page, first, count) for runs of the triangles from begin on, in submission order: spilled ones
+		// read PageTriangles at a time, then the ones still in triangles. Stops early when fn returns false.
+		// False if fn did or the spill file could not be read.
+		template <typename F>
+		bool forEachPage(size_t begin, F fn) const
+		{
+			TriangleStore page;
+			for (size_t start = begin; start < spilled.size(); start += PageTriangles)
+			{
+				page.clear();
+				if (!spill->read(spilled, start, std::min(spilled.size(), start + PageTriangles), page) || !fn((const TriangleStore &)page, (size_t)0, page.size()))
+					return false;
+			}
+			size_t first = begin > spilled.size() ? begin - spilled.size() : 0;
+			if (first < triangles.size())
+				return fn(triangles, first, triangles.size() - first);
+			return true;
+		}
+
+		// Offset that puts every builder in builders, plus extra, in positive space around a common origin:
+		// half the extent of their combined bounds plus a margin of 50 units on every axis
+		static glm::vec3 sharedOffset(Builder *const *builders, int count, const Bounds &extra);
+
+		// Feeds everything that affects the built DIF into hasher. False if spilled triangles could not be read back.
+		bool hashInputs(Hasher &hasher) const;
+
+		// Names and verifies the cache entry of these inputs
+		bool cacheKey(CacheKey &key) const;
+
+		// Makes path followers of identical pathed interiors share one sub object. Does nothing unless the DIF has
+		// exactly one sub object and path follower per pathed interior added, in order
+		void instancePathedInteriors(DIF::DIF &dif);
+
+		// False if the callback asked to cancel
+		bool reportProgress(int phase, float fraction);
+		void countOutput(const DIF::DIF &dif);
+
+		// Hands the pending triangles to DIFBuilder, builds the interior and welds it, or loads it from the cache.
+		// Returns false if the progress callback cancelled the build or spilled triangles could not be read back.
+		bool build(DIF::DIF &dif);
+	};
+}
@@ -0,0 +1,250 @@
+#include "Cache.h"
+#include "Reader.h"
+#include "Writer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <utime.h>
+#endif
+
+namespace DifBuilderLib
+{
+	namespace
+	{
+		// Written ahead of the DIF in every entry
+		struct CacheHeader
+		{
+			char magic[4];
+			uint32_t version;
+			uint64_t hash;
+			uint64_t check;
+			uint64_t inputBytes;
+			uint64_t triangles;
+		};
+
+		CacheHeader makeHeader(const CacheKey &key)
+		{
+			CacheHeader header;
+			memset(&header, 0, sizeof(header));
+			memcpy(header.magic, "DBLC", 4);
+			header.version = CacheVersion;
+			header.hash = key.hash;
+			header.check = key.check;
+			header.inputBytes = key.inputBytes;
+			header.triangles = key.triangles;
+			return header;
+		}
+
+		struct CacheEntry
+		{
+			std::string path;
+			unsigned long long bytes;
+			long long lastUsed;
+		};
+
+		// Temporary files storeCached did not get to rename, from a crash or a failed rename, go after this long.
+		// Anything younger may still be written by another export.
+		const long long TempMaxAgeSeconds = 60 * 60;
+
+		// 16 hex digits and .dif, as cachePath names them
+		bool isEntryName(const std::string &name)
+		{
+			if (name.size() != 20 || name.compare(16, 4, ".dif") != 0)
+				return false;
+			for (size_t i = 0; i < 16; i++)
+			{
+				if (!((name[i] >= '0' && name[i] <= '9') || (name[i] >= 'a' && name[i] <= 'f')))
+					return false;
+			}
+			return true;
+		}
+
+		// An entry name followed by a dot, a writer id and .tmp, as storeCached names them
+		bool isTempName(const std::string &name)
+		{
+			return name.size() > 25 && isEntryName(name.substr(0, 20)) && name[20] == '.' && name.compare(name.size() - 4, 4, ".tmp") == 0;
+		}
+
+		std::string joinPath(const std::string &dir, const std::string &name)
+		{
+			std::string path = dir;
+			if (!path.empty() && path.back() != '/' && path.back() != '\\')
+				path += '/';
+			return path + name;
+		}
+
+#ifdef _WIN32
+		std::wstring widen(const std::string &path)
+		{
+			int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, NULL, 0);
+			std::wstring widePath(length, L'\0');
+			MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &widePath[0], length);
+			return std::wstring(widePath.c_str());
+		}
+
+		std::string narrow(const std::wstring &path)
+		{
+			int length = WideCharToMultiByte(CP_UTF8, 0, path.c_str(), -1, NULL, 0, NULL, NULL);
+			std::string narrowPath(length, '\0');
+			WideCharToMultiByte(CP_UTF8, 0, path.c_str(), -1, &narrowPath[0], length, NULL, NULL);
+			return std::string(narrowPath.c_str());
+		}
+
+		long long unixSeconds(const FILETIME &time)
+		{
+			unsigned long long ticks = ((unsigned long long)time.dwHighDateTime << 32) | time.dwLowDateTime;
+			return (long long)((ticks - 116444736000000000ULL) / 10000000ULL);
+		}
+#endif
+
+		void touch(const std::string &path)
+		{
+#ifdef _WIN32
+			HANDLE file = CreateFileW(widen(path).c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, NULL);
+			if (file == INVALID_HANDLE_VALUE)
+				return;
+			FILETIME now;
+			GetSystemTimeAsFileTime(&now);
+			SetFileTime(file, NULL, NULL, &now);
+			CloseHandle(file);
+#else
+			utime(path.c_str(), NULL);
+#endif
+		}
+
+		// Files in cacheDir whose name passes match
+		template <typename F>
+		std::vector<CacheEntry> listEntries(const std::string &cacheDir, const char *pattern, F match)
+		{
+			std::vector<CacheEntry> entries;
+#ifdef _WIN32
+			WIN32_FIND_DATAW found;
+			HANDLE search = FindFirstFileW(widen(joinPath(cacheDir, pattern)).c_str(), &found);
+			if (search == INVALID_HANDLE_VALUE)
+				return entries;
+			do
+			{
+				std::string name = narrow(found.cFileName);
+				if ((found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || !match(name))
+					continue;
+				CacheEntry entry;
+				entry.path = joinPath(cacheDir, name);
+				entry.bytes = ((unsigned long long)found.nFileSizeHigh << 32) | found.nFileSizeLow;
+				entry.lastUsed = unixSeconds(found.ftLastWriteTime);
+				entries.push_back(entry);
+			} while (FindNextFileW(search, &found));
+			FindClose(search);
+#else
+			(void)pattern;
+			DIR *dir = opendir(cacheDir.c_str());
+			if (dir == NULL)
+				return entries;
+			while (struct dirent *found = readdir(dir))
+			{
+				std::string name = found->d_name;
+				if (!match(name))
+					continue;
+				CacheEntry entry;
+				entry.path = joinPath(cacheDir, name);
+				struct stat st;
+				if (stat(entry.path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+					continue;
+				entry.bytes = (unsigned long long)st.st_size;
+				entry.lastUsed = (long long)st.st_mtime;
+				entries.push_back(entry);
+			}
+			closedir(dir);
+#endif
+			return entries;
+		}
+
+		void removeFile(const std::string &path)
+		{
+#ifdef _WIN32
+			_wremove(widen(path).c_str());
+#else
+			std::remove(path.c_str());
+#endif
+		}
+
+		// Replaces to if it exists. rename on Windows fails then rather than replacing
+		bool renameFile(const std::string &from, const std::string &to)
+		{
+#ifdef _WIN32
+			return MoveFileExW(widen(from).c_str(), widen(to).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+			return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+		}
+	}
+
+	std::string cachePath(const std::string &cacheDir, const CacheKey &key)
+	{
+		static const char digits[] = "0123456789abcdef";
+		uint64_t h = key.hash;
+		std::string name(16, '0');
+		for (int i = 15; i >= 0; i--, h >>= 4)
+			name[i] = digits[h & 0xF];
+		return joinPath(cacheDir, name + ".dif");
+	}
+
+	bool loadCached(const std::string &path, const CacheKey &key, DIF::DIF &dif)
+	{
+		CacheHeader header = makeHeader(key);
+		if (!readDifWithHeader(path, &header, sizeof(header), dif))
+		{
+			dif = DIF::DIF();
+			return false;
+		}
+		touch(path);
+		return true;
+	}
+
+	void storeCached(const std::string &cacheDir, const std::string &path, const CacheKey &key, const DIF::DIF &dif)
+	{
+		CacheHeader header = makeHeader(key);
+		std::vector<char> data((const char *)&header, (const char *)&header + sizeof(header));
+		if (!serialize(dif, data))
+			return;
+
+		// Write to a private name and rename so a concurrent export never reads a half written entry
+		std::hash<std::thread::id> threadHash;
+		std::string temp = path + "." + std::to_string(threadHash(std::this_thread::get_id())) + ".tmp";
+		if (!writeFile(temp, data) || !renameFile(temp, path))
+			removeFile(temp);
+
+		pruneCache(cacheDir);
+	}
+
+	void pruneCache(const std::string &cacheDir)
+	{
+		long long now = (long long)time(NULL);
+		for (const CacheEntry &temp : listEntries(cacheDir, "*.tmp", isTempName))
+		{
+			if (temp.lastUsed < now - TempMaxAgeSeconds)
+				removeFile(temp.path);
+		}
+
+		std::vector<CacheEntry> entries = listEntries(cacheDir, "*.dif", isEntryName);
+		std::sort(entries.begin(), entries.end(), [](const CacheEntry &a, const CacheEntry &b) { return a.lastUsed > b.lastUsed; });
+
+		long long oldest = now - CacheMaxAgeSeconds;
+		unsigned long long total = 0;
+		for (const CacheEntry &entry : entries)
+		{
+			total += entry.bytes;
+			if (entry.lastUsed < oldest || total > CacheMaxBytes)
+				removeFile(entry.path);
+		}
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "DIFBuilder/DIFBuilder.hpp"
+#include <cstdint>
+#include <string>
+
+namespace DifBuilderLib
+{
+	// Bump when a change in the build makes existing cache entries stale
+	const uint32_t CacheVersion = 9;
+
+	// Entries not used for this long are removed
+	const long long CacheMaxAgeSeconds = 30LL * 24 * 60 * 60;
+
+	// After that the least recently used entries go until the directory holds no more than this
+	const unsigned long long CacheMaxBytes = 1ULL << 30;
+
+	// The inputs of a build. hash names the entry, everything is stored in it and checked on a hit.
+	struct CacheKey
+	{
+		uint64_t hash = 0;
+		// Hash of the same inputs with another seed
+		uint64_t check = 0;
+		uint64_t inputBytes = 0;
+		uint64_t triangles = 0;
+	};
+
+	// Where the DIF built from inputs matching key lives in cacheDir
+	std::string cachePath(const std::string &cacheDir, const CacheKey &key);
+
+	// Reads a cached DIF, leaves dif empty and returns false on a miss or an entry stored for other inputs.
+	// A hit marks the entry as recently used.
+	bool loadCached(const std::string &path, const CacheKey &key, DIF::DIF &dif);
+
+	// Stores dif in the cache and prunes it, a failure only costs the next build its cache hit
+	void storeCached(const std::string &cacheDir, const std::string &path, const CacheKey &key, const DIF::DIF &dif);
+
+	// Removes entries unused for CacheMaxAgeSeconds, then the least recently used ones down to CacheMaxBytes, and
+	// temporary files of stores that never finished once they are an hour old. Only files named like entries or
+	// their temporary files are touched.
+	void pruneCache(const std::string &cacheDir);
+}
@@ -1,28 +1,76 @@
 // dllmain.cpp : Defines the entry point for the DLL application.
 #include "DifBuilderLib.h"
 #include <DIFBuilder/DIFBuilder.hpp>
+#include "Parallel.h"
+#include "Limits.h"
+#include "Partition.h"
+#include "Reader.h"
+#include "Transform.h"
+#include "Writer.h"
+#include <cstring>
+#include <fstream>
+
+static_assert(sizeof(glm::vec3) == sizeof(float) * 3, "get_points and get_normals hand out glm::vec3 arrays as packed floats");
+
+namespace
+{
+	// Whether every index the surface holds, down to its winding points, is inside the interior. Read files are
+	// not trusted to be
+	bool validSurface(const DIF::Interior &interior, const DIF::Interior::Surface &surface)
+	{
+		U32 planeIndex = surface.planeIndex & 0x7FFF;
+		if (surface.texGenIndex >= interior.texGenEq.size() || planeIndex >= interior.plane.size())
+			return false;
+		if (interior.plane[planeIndex].normalIndex >= interior.normal.size())
+			return false;
+		if (surface.windingStart > interior.index.size() || surface.windingCount > interior.index.size() - surface.windingStart)
+			return false;
+		for (U32 i = 0; i < surface.windingCount; i++)
+		{
+			if (interior.index[surface.windingStart + i] >= interior.point.size())
+				return false;
+		}
+		return true;
+	}
+}
 
 extern "C"
 {
-	DIF::DIFBuilder *new_difbuilder()
+	DifBuilderLib::Builder *new_difbuilder()
 	{
-		return new DIF::DIFBuilder();
+		return new DifBuilderLib::Builder();
 	}
 
-	void dispose_difbuilder(DIF::DIFBuilder *difbuilder)
+	void dispose_difbuilder(DifBuilderLib::Builder *difbuilder)
 	{
 		if (difbuilder != NULL)
 			delete difbuilder;
 	}
 
+	void reserve_difbuilder(DifBuilderLib::Builder *difbuilder, int triangleCount)
+	{
+		difbuilder->reserve(triangleCount);
+	}
+
+	void reset_difbuilder(DifBuilderLib::Builder *difbuilder)
+	{
+		difbuilder->reset();
+	}
+
 	void dispose_dif(DIF::DIF *dif)
 	{
 		if (dif != NULL)
 			delete dif;
 	}
 
-	void add_triangle(DIF::DIFBuilder *builder, float *p1, float *p2, float *p3, float *uv1, float *uv2, float *uv3, float *n, char *material)
+	int register_material(DifBuilderLib::Builder *builder, char *name)
 	{
+		return builder->registerMaterial(std::string(name));
+	}
+
+	void add_triangle(DifBuilderLib::Builder *builder, float *p1, float *p2, float *p3, float *uv1, float *uv2, float *uv3, float *n, char *material)
+	{
+		DifBuilderLib::Stopwatch submitTime;
 		DIF::DIFBuilder::Triangle tri = DIF::DIFBuilder::Triangle();
 		tri.points[0].vertex = glm::vec3(p1[0], p1[1], p1[2]);
 		tri.points[1].vertex = glm::vec3(p2[0], p2[1], p2[2]);
@@ -36,22 +84,252 @@ extern "C"
 		tri.points[1].normal = tri.points[0].normal;
 		tri.points[2].normal = tri.points[0].normal;
 
-		builder->addTriangle(tri, std::string(material));
+		builder->addTriangle(tri, builder->registerMaterial(std::string(material)));
+		builder->stats.submitSeconds += submitTime.seconds();
+	}
+
+	// positions: 9 floats per triangle, uvs: 6 floats per triangle, normals: 3 floats per triangle,
+	// materialIds: one id returned by register_material per triangle.
+	// matrix: 16 floats, row major, applied to positions and through its inverse transpose to normals, or NULL.
+	// Every triangle keeps its own three points and UVs, about 100 bytes each; add_indexed_mesh shares them.
+	void add_triangles(DifBuilderLib::Builder *builder, float *positions, float *uvs, float *normals, int *materialIds, int count, float *matrix)
+	{
+		DifBuilderLib::Stopwatch submitTime;
+		std::vector<glm::vec3> transformedPositions;
+		std::vector<glm::vec3> transformedNormals;
+		if (matrix != NULL && count > 0)
+		{
+			glm::mat4 transform = DifBuilderLib::matrixFromRows(matrix);
+			transformedPositions.resize((size_t)count * 3);
+			transformedNormals.resize((size_t)count);
+			DifBuilderLib::transformPoints(transform, positions, (size_t)count * 3, transformedPositions.data());
+			DifBuilderLib::transformNormals(transform, normals, (size_t)count, transformedNormals.data());
+			positions = &transformedPositions[0].x;
+			normals = &transformedNormals[0].x;
+		}
+
+		DIF::DIFBuilder::Triangle tri = DIF::DIFBuilder::Triangle();
+		for (int i = 0; i < count; i++)
+		{
+			const float *p = positions + i * 9;
+			const float *uv = uvs + i * 6;
+			const float *n = normals + i * 3;
+
+			tri.points[0].vertex = glm::vec3(p[0], p[1], p[2]);
+			tri.points[1].vertex = glm::vec3(p[3], p[4], p[5]);
+			tri.points[2].vertex = glm::vec3(p[6], p[7], p[8]);
+
+			tri.points[0].uv = glm::vec2(uv[0], uv[1]);
+			tri.points[1].uv = glm::vec2(uv[2], uv[3]);
+			tri.points[2].uv = glm::vec2(uv[4], uv[5]);
+
+			tri.points[0].normal = glm::vec3(n[0], n[1], n[2]);
+			tri.points[1].normal = tri.points[0].normal;
+			tri.points[2].normal = tri.points[0].normal;
+
+			builder->addTriangle(tri, materialIds[i]);
+		}
+		builder->stats.submitSeconds += submitTime.seconds();
+	}
+
+	// positions: 3 floats per vertex, uvs: 2 floats per loop or NULL, loopVertices: vertex index per loop,
+	// loopCounts and materialIds: per polygon, polygons use consecutive loops and are fan triangulated.
+	// matrix: 16 floats, row major, applied to positions, or NULL. Polygons with a loop vertex outside
+	// [0, vertexCount) are skipped.
+	void add_indexed_mesh(DifBuilderLib::Builder *builder, float *positions, int vertexCount, float *uvs, int *loopVertices, int loopCount, int *loopCounts, int *materialIds, int polyCount, float *matrix)
+	{
+		DifBuilderLib::Stopwatch submitTime;
+		builder->addIndexedMesh(positions, vertexCount, uvs, loopVertices, loopCount, loopCounts, materialIds, polyCount, matrix);
+		builder->stats.submitSeconds += submitTime.seconds();
+	}
+
+	void set_weld_tolerances(DifBuilderLib::Builder *builder, float point, float normal, float planeDistance, float texGen)
+	{
+		builder->weld.point = point;
+		builder->weld.normal = normal;
+		builder->weld.planeDistance = planeDistance;
+		builder->weld.texGen = texGen;
+	}
+
+	void set_optimize_layout(DifBuilderLib::Builder *builder, bool enabled)
+	{
+		builder->optimizeLayout = enabled;
+	}
+
+	void set_merge_surfaces(DifBuilderLib::Builder *builder, bool enabled)
+	{
+		builder->mergeSurfaces = enabled;
+	}
+
+	// flags is a combination of DifBuilderLib::FaceFlags, applied to every triangle at build time
+	void set_face_mode(DifBuilderLib::Builder *builder, int flags)
+	{
+		builder->faceFlags = flags;
+	}
+
+	// dir is UTF-8, NULL or empty turns the cache off. Every store prunes entries unused for 30 days, then the
+	// least recently used ones until the directory holds at most 1 GiB of entries
+	void set_build_cache(DifBuilderLib::Builder *builder, char *dir)
+	{
+		builder->cacheDir = dir == NULL ? std::string() : std::string(dir);
+	}
+
+	// Moves submitted triangles to a temporary file in dir every spillTriangles triangles, and pages each chunk
+	// back in only while handing it to DIFBuilder. dir is UTF-8, NULL or empty uses the system temporary
+	// directory. spillTriangles <= 0 turns streaming off, triangles submitted from then on stay in memory.
+	// Partitioned builders inherit it.
+	void set_streaming(DifBuilderLib::Builder *builder, char *dir, int spillTriangles)
+	{
+		builder->spillDir = dir == NULL ? std::string() : std::string(dir);
+		builder->spillThreshold = spillTriangles > 0 ? (size_t)spillTriangles : 0;
+		if (builder->spillThreshold > 0 && builder->triangles.size() >= builder->spillThreshold)
+			builder->spillTriangles();
+	}
+
+	// Returns false and leaves min and max alone if nothing was submitted
+	bool get_bounds(DifBuilderLib::Builder *builder, float *min, float *max)
+	{
+		if (builder->bounds.empty())
+			return false;
+		memcpy(min, &builder->bounds.min, sizeof(float) * 3);
+		memcpy(max, &builder->bounds.max, sizeof(float) * 3);
+		return true;
+	}
+
+	// Added to every vertex at build, partitioned chunks inherit it
+	void set_offset(DifBuilderLib::Builder *builder, float *offset)
+	{
+		builder->offset = glm::vec3(offset[0], offset[1], offset[2]);
+	}
+
+	// Offset for every builder sharing one origin, extraMin and extraMax add bounds of geometry that is
+	// not submitted yet and may be NULL
+	void compute_shared_offset(DifBuilderLib::Builder **builders, int count, float *extraMin, float *extraMax, float *outOffset)
+	{
+		DifBuilderLib::Bounds extra;
+		if (extraMin != NULL && extraMax != NULL)
+		{
+			extra.extend(glm::vec3(extraMin[0], extraMin[1], extraMin[2]));
+			extra.extend(glm::vec3(extraMax[0], extraMax[1], extraMax[2]));
+		}
+		glm::vec3 offset = DifBuilderLib::Builder::sharedOffset(builders, count, extra);
+		memcpy(outOffset, &offset, sizeof(float) * 3);
+	}
+
+	int get_triangle_count(DifBuilderLib::Builder *builder)
+	{
+		return (int)builder->triangleCount();
+	}
+
+	int get_partition_count(DifBuilderLib::Builder *builder, int maxTriangles)
+	{
+		return DifBuilderLib::partitionCount(*builder, maxTriangles);
+	}
+
+	// Moves the triangles of builder into get_partition_count spatially compact chunks.
+	// strategy is a DifBuilderLib::PartitionStrategy.
+	// The chunks are new builders owned by the caller; pathed interiors and triggers added to builder are added to the first one too.
+	void partition_difbuilder(DifBuilderLib::Builder *builder, int maxTriangles, int strategy, DifBuilderLib::Builder **outBuilders)
+	{
+		DifBuilderLib::Stopwatch partitionTime;
+		std::vector<DifBuilderLib::Builder *> chunks = DifBuilderLib::partition(*builder, maxTriangles, (DifBuilderLib::PartitionStrategy)strategy);
+		std::copy(chunks.begin(), chunks.end(), outBuilders);
+		builder->stats.partitionSeconds += partitionTime.seconds();
+	}
+
+	// Largest ratio of count to format limit in dif, above 1 means it can't be written
+	double get_limit_usage(DIF::DIF *dif)
+	{
+		return DifBuilderLib::limitUsage(*dif);
+	}
+
+	// Budget to partition_difbuilder builder with when dif, built from it, crosses a format limit, 0 if it fits.
+	// builder keeps its triangles after build for this, in the spill file if it streams.
+	int get_split_budget(DifBuilderLib::Builder *builder, DIF::DIF *dif)
+	{
+		return DifBuilderLib::splitBudget(*builder, *dif);
+	}
+
+	// Budget to first partition_difbuilder with, from the format limits
+	int get_start_budget()
+	{
+		return DifBuilderLib::startBudget();
+	}
+
+	// callback may be NULL, partitioned chunks inherit it
+	void set_progress_callback(DifBuilderLib::Builder *builder, DifBuilderLib::ProgressCallback callback, void *user)
+	{
+		builder->progress = callback;
+		builder->progressUser = user;
+	}
+
+	void get_build_stats(DifBuilderLib::Builder *builder, DifBuilderLib::BuildStats *stats)
+	{
+		*stats = builder->stats;
+	}
+
+	// NULL if the progress callback cancelled the build
+	DIF::DIF *build(DifBuilderLib::Builder *builder)
+	{
+		DIF::DIF *dif = new DIF::DIF();
+		if (!builder->build(*dif))
+		{
+			delete dif;
+			return NULL;
+		}
+		return dif;
+	}
+
+	// Builds independent builders on a worker pool, threads <= 0 uses every core.
+	// outDifs[i] is NULL if building difbuilders[i] failed or was cancelled.
+	void build_many(DifBuilderLib::Builder **builders, int count, DIF::DIF **outDifs, int threads)
+	{
+		DifBuilderLib::parallelFor(count, threads, [&](int i) {
+			try
+			{
+				outDifs[i] = build(builders[i]);
+			}
+			catch (...)
+			{
+				outDifs[i] = NULL;
+			}
+		});
+	}
+
+	// Builds difbuilder on the shared worker pool. difbuilder must not be used until wait_build, which also frees the job.
+	DifBuilderLib::BuildJob *build_async(DifBuilderLib::Builder *builder)
+	{
+		return DifBuilderLib::startBuild(builder);
+	}
+
+	// True once the build is done, progress (may be NULL) gets the rough overall fraction
+	bool poll_build(DifBuilderLib::BuildJob *job, float *progress)
+	{
+		if (progress != NULL)
+			*progress = job->progress();
+		return job->done;
+	}
+
+	// Stops the build at the next phase boundary, wait_build then returns NULL
+	void cancel_build(DifBuilderLib::BuildJob *job)
+	{
+		job->cancelled = true;
 	}
 
-	DIF::DIF *build(DIF::DIFBuilder *builder)
+	// NULL if the build failed or was cancelled
+	DIF::DIF *wait_build(DifBuilderLib::BuildJob *job)
 	{
-		DIF::DIF dif;
-		builder->build(dif);
-		return new DIF::DIF(dif);
+		DIF::DIF *dif = job->wait();
+		delete job;
+		return dif;
 	}
 
-	void add_pathed_interior(DIF::DIFBuilder *builder, DIF::DIF *dif, std::vector<DIF::DIFBuilder::Marker> *markerlist)
+	void add_pathed_interior(DifBuilderLib::Builder *builder, DIF::DIF *dif, std::vector<DIF::DIFBuilder::Marker> *markerlist)
 	{
 		builder->addPathedInterior(dif->interior[0], *markerlist);
 	}
 
-	void add_trigger(DIF::DIFBuilder *difbuilder, float *position, char *name, char *datablock, DIF::Dictionary *props)
+	void add_trigger(DifBuilderLib::Builder *difbuilder, float *position, char *name, char *datablock, DIF::Dictionary *props)
 	{
 		DIF::DIFBuilder::Trigger trigger;
 		trigger.name = std::string(name);
@@ -61,13 +339,96 @@ extern "C"
 		difbuilder->addTrigger(trigger);
 	}
 
-	void write_dif(DIF::DIF *dif, char *path)
+	// path is UTF-8
+	bool write_dif(DIF::DIF *dif, char *path)
+	{
+		std::vector<char> data;
+		return DifBuilderLib::serialize(*dif, data) && DifBuilderLib::writeFile(std::string(path), data);
+	}
+
+	// Moves the interiors of source to the end of dif's. Torque reads the interiors of a DIF as detail levels,
+	// highest first, and draws and collides with one of them at a time, so this is for LODs and not for the
+	// chunks of a split export. Pathed interiors, triggers and game entities of source stay where they are.
+	void append_interior(DIF::DIF *dif, DIF::DIF *source)
+	{
+		dif->interior.reserve(dif->interior.size() + source->interior.size());
+		for (DIF::Interior &interior : source->interior)
+			dif->interior.push_back(std::move(interior));
+		source->interior.clear();
+	}
+
+	// Writes difs[0] with the interiors of the others appended as detail levels, see append_interior.
+	// The difs are left as they were.
+	bool write_multi_dif(DIF::DIF **difs, int count, char *path)
+	{
+		if (count <= 0)
+			return false;
+
+		DIF::DIF *dif = difs[0];
+		size_t ownInteriors = dif->interior.size();
+		std::vector<size_t> borrowed((size_t)count, 0);
+		for (int i = 1; i < count; i++)
+		{
+			borrowed[i] = difs[i]->interior.size();
+			append_interior(dif, difs[i]);
+		}
+
+		std::vector<char> data;
+		bool ok = DifBuilderLib::serialize(*dif, data);
+
+		// Hand the borrowed interiors back in order
+		size_t next = ownInteriors;
+		for (int i = 1; i < count; i++)
+		{
+			for (size_t j = 0; j < borrowed[i]; j++)
+				difs[i]->interior.push_back(std::move(dif->interior[next++]));
+		}
+		dif->interior.erase(dif->interior.begin() + ownInteriors, dif->interior.end());
+		return ok && DifBuilderLib::writeFile(std::string(path), data);
+	}
+
+	std::vector<char> *write_dif_to_buffer(DIF::DIF *dif)
+	{
+		std::vector<char> *data = new std::vector<char>();
+		if (!DifBuilderLib::serialize(*dif, *data))
+		{
+			delete data;
+			return NULL;
+		}
+		return data;
+	}
+
+	const char *get_buffer_data(std::vector<char> *buffer)
 	{
-		std::ofstream outStr;
-		outStr.open(path, std::ios::out | std::ios::binary);
-		DIF::Version ver;
-		ver.dif.type = DIF::Version::DIFVersion::MBG;
-		dif->write(outStr, ver);
+		return buffer->data();
+	}
+
+	int get_buffer_size(std::vector<char> *buffer)
+	{
+		return (int)buffer->size();
+	}
+
+	void dispose_buffer(std::vector<char> *buffer)
+	{
+		delete buffer;
+	}
+
+	// Serializes and writes dif on a background thread. dif must stay alive and unmodified
+	// until wait_write, which also frees the job.
+	std::future<bool> *write_dif_async(DIF::DIF *dif, char *path)
+	{
+		std::string pathStr(path);
+		return new std::future<bool>(std::async(std::launch::async, [dif, pathStr]() {
+			std::vector<char> data;
+			return DifBuilderLib::serialize(*dif, data) && DifBuilderLib::writeFile(pathStr, data);
+		}));
+	}
+
+	bool wait_write(std::future<bool> *job)
+	{
+		bool ok = job->get();
+		delete job;
+		return ok;
 	}
 
 	std::vector<DIF::DIFBuilder::Marker> *new_marker_list()
@@ -117,4 +478,318 @@ extern "C"
 	{
 		dict->push_back(std::pair<std::string, std::string>(std::string(key), std::string(value)));
 	}
+
+	int get_dict_count(DIF::Dictionary *dict)
+	{
+		return (int)dict->size();
+	}
+
+	const char *get_dict_key(DIF::Dictionary *dict, int index)
+	{
+		return (*dict)[index].first.c_str();
+	}
+
+	const char *get_dict_value(DIF::Dictionary *dict, int index)
+	{
+		return (*dict)[index].second.c_str();
+	}
+
+	// path is UTF-8
+	DIF::DIF *read_dif(char *path)
+	{
+		return read_dif_filtered(path, DifBuilderLib::DIF_SECTION_ALL);
+	}
+
+	// Reads only the sections in sections, a mask of DifBuilderLib::DifSection. Interiors, sub objects and
+	// lightmaps left out are skipped without being parsed, the rest are read and then freed.
+	DIF::DIF *read_dif_filtered(char *path, int sections)
+	{
+		DIF::DIF *dif = new DIF::DIF();
+		if (!DifBuilderLib::readDifSections(std::string(path), sections, *dif))
+		{
+			delete dif;
+			return NULL;
+		}
+		return dif;
+	}
+
+	// Works on built and read DIFs alike, sections dropped by read_dif_filtered count as empty
+	void analyze_dif(DIF::DIF *dif, DifBuilderLib::AnalysisReport *report)
+	{
+		DifBuilderLib::analyzeDif(*dif, *report);
+	}
+
+	void analyze_interior(DIF::Interior *interior, DifBuilderLib::AnalysisReport *report)
+	{
+		DifBuilderLib::analyzeInterior(*interior, *report);
+	}
+
+	int get_interior_count(DIF::DIF *dif)
+	{
+		return (int)dif->interior.size();
+	}
+
+	DIF::Interior *get_interior(DIF::DIF *dif, int index)
+	{
+		return &dif->interior[index];
+	}
+
+	int get_sub_object_count(DIF::DIF *dif)
+	{
+		return (int)dif->subObject.size();
+	}
+
+	DIF::Interior *get_sub_object(DIF::DIF *dif, int index)
+	{
+		return &dif->subObject[index];
+	}
+
+	int get_point_count(DIF::Interior *interior)
+	{
+		return (int)interior->point.size();
+	}
+
+	float *get_points(DIF::Interior *interior)
+	{
+		return reinterpret_cast<float *>(interior->point.data());
+	}
+
+	int get_normal_count(DIF::Interior *interior)
+	{
+		return (int)interior->normal.size();
+	}
+
+	float *get_normals(DIF::Interior *interior)
+	{
+		return reinterpret_cast<float *>(interior->normal.data());
+	}
+
+	int get_winding_count(DIF::Interior *interior)
+	{
+		return (int)interior->index.size();
+	}
+
+	unsigned int *get_windings(DIF::Interior *interior)
+	{
+		return interior->index.data();
+	}
+
+	int get_plane_count(DIF::Interior *interior)
+	{
+		return (int)interior->plane.size();
+	}
+
+	void get_planes(DIF::Interior *interior, int *normalIndices, float *distances)
+	{
+		for (size_t i = 0; i < interior->plane.size(); i++)
+		{
+			normalIndices[i] = interior->plane[i].normalIndex;
+			distances[i] = interior->plane[i].planeDistance;
+		}
+	}
+
+	int get_texgen_count(DIF::Interior *interior)
+	{
+		return (int)interior->texGenEq.size();
+	}
+
+	// texgens: 8 floats per TexGenEQ, planeX xyzd followed by planeY xyzd
+	void get_texgens(DIF::Interior *interior, float *texgens)
+	{
+		for (size_t i = 0; i < interior->texGenEq.size(); i++)
+		{
+			const DIF::Interior::TexGenEq &texGen = interior->texGenEq[i];
+			float *out = texgens + i * 8;
+			out[0] = texGen.planeX.x;
+			out[1] = texGen.planeX.y;
+			out[2] = texGen.planeX.z;
+			out[3] = texGen.planeX.d;
+			out[4] = texGen.planeY.x;
+			out[5] = texGen.planeY.y;
+			out[6] = texGen.planeY.z;
+			out[7] = texGen.planeY.d;
+		}
+	}
+
+	int get_surface_count(DIF::Interior *interior)
+	{
+		return (int)interior->surface.size();
+	}
+
+	// planeIndices carry the 0x8000 flag for flipped planes, like the file does. Surfaces with indices out of range
+	// get a windingCount of 0, extract_mesh skips them
+	void get_surfaces(DIF::Interior *interior, int *windingStarts, int *windingCounts, int *planeIndices, int *textureIndices, int *texGenIndices)
+	{
+		for (size_t i = 0; i < interior->surface.size(); i++)
+		{
+			const DIF::Interior::Surface &surface = interior->surface[i];
+			windingStarts[i] = surface.windingStart;
+			windingCounts[i] = validSurface(*interior, surface) ? surface.windingCount : 0;
+			planeIndices[i] = surface.planeIndex | (surface.planeFlipped ? 0x8000 : 0);
+			textureIndices[i] = surface.textureIndex;
+			texGenIndices[i] = surface.texGenIndex;
+		}
+	}
+
+	int get_material_count(DIF::Interior *interior)
+	{
+		return (int)interior->materialName.size();
+	}
+
+	const char *get_material_name(DIF::Interior *interior, int index)
+	{
+		return interior->materialName[index].c_str();
+	}
+
+	void get_mesh_sizes(DIF::Interior *interior, int *vertexCount, int *triangleCount)
+	{
+		int triangles = 0;
+		for (const DIF::Interior::Surface &surface : interior->surface)
+		{
+			if (surface.windingCount > 2 && validSurface(*interior, surface))
+				triangles += surface.windingCount - 2;
+		}
+		*vertexCount = (int)interior->point.size();
+		*triangleCount = triangles;
+	}
+
+	// Triangulates the surface windings (stored as strips) into Blender-style buffers:
+	// positions: 3 floats per point, loopVertices: 3 per triangle, loopUVs: 6 floats per triangle,
+	// polyMaterials: 1 per triangle, polyNormals: 3 floats per triangle or NULL.
+	// Buffers are sized from get_mesh_sizes. Surfaces with indices out of range are skipped.
+	void extract_mesh(DIF::Interior *interior, float *positions, int *loopVertices, float *loopUVs, int *polyMaterials, float *polyNormals)
+	{
+		memcpy(positions, interior->point.data(), interior->point.size() * sizeof(glm::vec3));
+
+		size_t tri = 0;
+		for (const DIF::Interior::Surface &surface : interior->surface)
+		{
+			if (!validSurface(*interior, surface))
+				continue;
+
+			const DIF::Interior::TexGenEq &texGen = interior->texGenEq[surface.texGenIndex];
+			glm::vec3 normal = interior->normal[interior->plane[surface.planeIndex & 0x7FFF].normalIndex];
+			if (surface.planeFlipped)
+				normal = -normal;
+
+			for (int i = 0; i + 2 < (int)surface.windingCount; i++)
+			{
+				const unsigned int *winding = &interior->index[surface.windingStart + i];
+				unsigned int corners[3];
+				if (i % 2 == 0)
+				{
+					corners[0] = winding[2];
+					corners[1] = winding[1];
+					corners[2] = winding[0];
+				}
+				else
+				{
+					corners[0] = winding[0];
+					corners[1] = winding[1];
+					corners[2] = winding[2];
+				}
+
+				for (int j = 0; j < 3; j++)
+				{
+					const glm::vec3 &pt = interior->point[corners[j]];
+					loopVertices[tri * 3 + j] = corners[j];
+					loopUVs[tri * 6 + j * 2 + 0] = pt.x * texGen.planeX.x + pt.y * texGen.planeX.y + pt.z * texGen.planeX.z + texGen.planeX.d;
+					loopUVs[tri * 6 + j * 2 + 1] = pt.x * texGen.planeY.x + pt.y * texGen.planeY.y + pt.z * texGen.planeY.z + texGen.planeY.d;
+				}
+
+				polyMaterials[tri] = surface.textureIndex;
+				if (polyNormals != NULL)
+				{
+					polyNormals[tri * 3 + 0] = normal.x;
+					polyNormals[tri * 3 + 1] = normal.y;
+					polyNormals[tri * 3 + 2] = normal.z;
+				}
+				tri++;
+			}
+		}
+	}
+
+	int get_path_follower_count(DIF::DIF *dif)
+	{
+		return (int)dif->interiorPathFollower.size();
+	}
+
+	const char *get_path_follower_name(DIF::DIF *dif, int index)
+	{
+		return dif->interiorPathFollower[index].name.c_str();
+	}
+
+	const char *get_path_follower_datablock(DIF::DIF *dif, int index)
+	{
+		return dif->interiorPathFollower[index].datablock.c_str();
+	}
+
+	int get_path_follower_interior(DIF::DIF *dif, int index)
+	{
+		return dif->interiorPathFollower[index].interiorResIndex;
+	}
+
+	void get_path_follower_offset(DIF::DIF *dif, int index, float *offset)
+	{
+		const glm::vec3 &off = dif->interiorPathFollower[index].offset;
+		offset[0] = off.x;
+		offset[1] = off.y;
+		offset[2] = off.z;
+	}
+
+	DIF::Dictionary *get_path_follower_properties(DIF::DIF *dif, int index)
+	{
+		return &dif->interiorPathFollower[index].properties;
+	}
+
+	int get_path_follower_waypoint_count(DIF::DIF *dif, int index)
+	{
+		return (int)dif->interiorPathFollower[index].wayPoint.size();
+	}
+
+	// positions: 3 floats per waypoint, rotations: 4 floats (xyzw) per waypoint
+	void get_path_follower_waypoints(DIF::DIF *dif, int index, float *positions, float *rotations, int *msToNext, int *smoothingTypes)
+	{
+		const std::vector<DIF::InteriorPathFollower::WayPoint> &wayPoints = dif->interiorPathFollower[index].wayPoint;
+		for (size_t i = 0; i < wayPoints.size(); i++)
+		{
+			positions[i * 3 + 0] = wayPoints[i].position.x;
+			positions[i * 3 + 1] = wayPoints[i].position.y;
+			positions[i * 3 + 2] = wayPoints[i].position.z;
+			rotations[i * 4 + 0] = wayPoints[i].rotation.x;
+			rotations[i * 4 + 1] = wayPoints[i].rotation.y;
+			rotations[i * 4 + 2] = wayPoints[i].rotation.z;
+			rotations[i * 4 + 3] = wayPoints[i].rotation.w;
+			msToNext[i] = wayPoints[i].msToNext;
+			smoothingTypes[i] = wayPoints[i].smoothingType;
+		}
+	}
+
+	int get_game_entity_count(DIF::DIF *dif)
+	{
+		return (int)dif->gameEntity.size();
+	}
+
+	const char *get_game_entity_class(DIF::DIF *dif, int index)
+	{
+		return dif->gameEntity[index].gameClass.c_str();
+	}
+
+	const char *get_game_entity_datablock(DIF::DIF *dif, int index)
+	{
+		return dif->gameEntity[index].datablock.c_str();
+	}
+
+	void get_game_entity_position(DIF::DIF *dif, int index, float *position)
+	{
+		const glm::vec3 &pos = dif->gameEntity[index].position;
+		position[0] = pos.x;
+		position[1] = pos.y;
+		position[2] = pos.z;
+	}
+
+	DIF::Dictionary *get_game_entity_properties(DIF::DIF *dif, int index)
+	{
+		return &dif->gameEntity[index].properties;
+	}
 }
@@ -1,5 +1,9 @@
 #pragma once
 #include "DIFBuilder/DIFBuilder.hpp"
+#include "Analysis.h"
+#include "Builder.h"
+#include "BuildJob.h"
+#include <future>
 
 #if _MSC_VER
 #define PLUGIN_API __declspec(dllexport)
@@ -9,19 +13,89 @@
 
 extern "C"
 {
-	PLUGIN_API DIF::DIFBuilder *new_difbuilder();
+	PLUGIN_API DifBuilderLib::Builder *new_difbuilder();
 
-	PLUGIN_API void dispose_difbuilder(DIF::DIFBuilder *difbuilder);
+	PLUGIN_API void dispose_difbuilder(DifBuilderLib::Builder *difbuilder);
+
+	PLUGIN_API void reserve_difbuilder(DifBuilderLib::Builder *difbuilder, int triangleCount);
+
+	PLUGIN_API void reset_difbuilder(DifBuilderLib::Builder *difbuilder);
 
 	PLUGIN_API void dispose_dif(DIF::DIF *dif);
 
-	PLUGIN_API void add_triangle(DIF::DIFBuilder *difbuilder, float *p1, float *p2, float *p3, float *uv1, float *uv2, float *uv3, float *n, char *material);
+	PLUGIN_API void add_triangle(DifBuilderLib::Builder *difbuilder, float *p1, float *p2, float *p3, float *uv1, float *uv2, float *uv3, float *n, char *material);
+
+	PLUGIN_API int register_material(DifBuilderLib::Builder *difbuilder, char *name);
+
+	PLUGIN_API void add_triangles(DifBuilderLib::Builder *difbuilder, float *positions, float *uvs, float *normals, int *materialIds, int count, float *matrix);
+
+	PLUGIN_API void add_indexed_mesh(DifBuilderLib::Builder *difbuilder, float *positions, int vertexCount, float *uvs, int *loopVertices, int loopCount, int *loopCounts, int *materialIds, int polyCount, float *matrix);
+
+	PLUGIN_API void set_weld_tolerances(DifBuilderLib::Builder *difbuilder, float point, float normal, float planeDistance, float texGen);
+
+	PLUGIN_API void set_optimize_layout(DifBuilderLib::Builder *difbuilder, bool enabled);
+
+	PLUGIN_API void set_merge_surfaces(DifBuilderLib::Builder *difbuilder, bool enabled);
+
+	PLUGIN_API void set_face_mode(DifBuilderLib::Builder *difbuilder, int flags);
+
+	PLUGIN_API void set_build_cache(DifBuilderLib::Builder *difbuilder, char *dir);
+
+	PLUGIN_API void set_streaming(DifBuilderLib::Builder *difbuilder, char *dir, int spillTriangles);
+
+	PLUGIN_API bool get_bounds(DifBuilderLib::Builder *difbuilder, float *min, float *max);
+
+	PLUGIN_API void set_offset(DifBuilderLib::Builder *difbuilder, float *offset);
+
+	PLUGIN_API void compute_shared_offset(DifBuilderLib::Builder **difbuilders, int count, float *extraMin, float *extraMax, float *outOffset);
+
+	PLUGIN_API int get_triangle_count(DifBuilderLib::Builder *difbuilder);
+
+	PLUGIN_API int get_partition_count(DifBuilderLib::Builder *difbuilder, int maxTriangles);
+
+	PLUGIN_API void partition_difbuilder(DifBuilderLib::Builder *difbuilder, int maxTriangles, int strategy, DifBuilderLib::Builder **outBuilders);
+
+	PLUGIN_API void set_progress_callback(DifBuilderLib::Builder *difbuilder, DifBuilderLib::ProgressCallback callback, void *user);
+
+	PLUGIN_API void get_build_stats(DifBuilderLib::Builder *difbuilder, DifBuilderLib::BuildStats *stats);
 
-	PLUGIN_API DIF::DIF *build(DIF::DIFBuilder *difbuilder);
+	PLUGIN_API DIF::DIF *build(DifBuilderLib::Builder *difbuilder);
 
-	PLUGIN_API void add_pathed_interior(DIF::DIFBuilder *difbuilder, DIF::DIF *difptr, std::vector<DIF::DIFBuilder::Marker> *markerlist);
+	PLUGIN_API double get_limit_usage(DIF::DIF *dif);
 
-	PLUGIN_API void write_dif(DIF::DIF *dif, char *path);
+	PLUGIN_API int get_split_budget(DifBuilderLib::Builder *difbuilder, DIF::DIF *dif);
+
+	PLUGIN_API int get_start_budget();
+
+	PLUGIN_API void build_many(DifBuilderLib::Builder **difbuilders, int count, DIF::DIF **outDifs, int threads);
+
+	PLUGIN_API DifBuilderLib::BuildJob *build_async(DifBuilderLib::Builder *difbuilder);
+
+	PLUGIN_API bool poll_build(DifBuilderLib::BuildJob *job, float *progress);
+
+	PLUGIN_API void cancel_build(DifBuilderLib::BuildJob *job);
+
+	PLUGIN_API DIF::DIF *wait_build(DifBuilderLib::BuildJob *job);
+
+	PLUGIN_API void add_pathed_interior(DifBuilderLib::Builder *difbuilder, DIF::DIF *difptr, std::vector<DIF::DIFBuilder::Marker> *markerlist);
+
+	PLUGIN_API bool write_dif(DIF::DIF *dif, char *path);
+
+	PLUGIN_API void append_interior(DIF::DIF *dif, DIF::DIF *source);
+
+	PLUGIN_API bool write_multi_dif(DIF::DIF **difs, int count, char *path);
+
+	PLUGIN_API std::vector<char> *write_dif_to_buffer(DIF::DIF *dif);
+
+	PLUGIN_API const char *get_buffer_data(std::vector<char> *buffer);
+
+	PLUGIN_API int get_buffer_size(std::vector<char> *buffer);
+
+	PLUGIN_API void dispose_buffer(std::vector<char> *buffer);
+
+	PLUGIN_API std::future<bool> *write_dif_async(DIF::DIF *dif, char *path);
+
+	PLUGIN_API bool wait_write(std::future<bool> *job);
 
 	PLUGIN_API std::vector<DIF::DIFBuilder::Marker> *new_marker_list();
 
@@ -31,11 +105,91 @@ extern "C"
 
 	PLUGIN_API void add_game_entity(DIF::DIF *dif, char *gameClass, char *datablock, float *pos, DIF::Dictionary *dict);
 
-	PLUGIN_API void add_trigger(DIF::DIFBuilder *difbuilder, float *position, char *name, char *datablock, DIF::Dictionary *props);
+	PLUGIN_API void add_trigger(DifBuilderLib::Builder *difbuilder, float *position, char *name, char *datablock, DIF::Dictionary *props);
 
 	PLUGIN_API DIF::Dictionary *new_dict();
 
 	PLUGIN_API void dispose_dict(DIF::Dictionary *dict);
 
 	PLUGIN_API void add_dict_kvp(DIF::Dictionary *dict, char *key, char *value);
+
+	PLUGIN_API int get_dict_count(DIF::Dictionary *dict);
+
+	PLUGIN_API const char *get_dict_key(DIF::Dictionary *dict, int index);
+
+	PLUGIN_API const char *get_dict_value(DIF::Dictionary *dict, int index);
+
+	PLUGIN_API DIF::DIF *read_dif(char *path);
+
+	PLUGIN_API DIF::DIF *read_dif_filtered(char *path, int sections);
+
+	PLUGIN_API void analyze_dif(DIF::DIF *dif, DifBuilderLib::AnalysisReport *report);
+
+	PLUGIN_API void analyze_interior(DIF::Interior *interior, DifBuilderLib::AnalysisReport *report);
+
+	PLUGIN_API int get_interior_count(DIF::DIF *dif);
+
+	PLUGIN_API DIF::Interior *get_interior(DIF::DIF *dif, int index);
+
+	PLUGIN_API int get_sub_object_count(DIF::DIF *dif);
+
+	PLUGIN_API DIF::Interior *get_sub_object(DIF::DIF *dif, int index);
+
+	PLUGIN_API int get_point_count(DIF::Interior *interior);
+
+	PLUGIN_API float *get_points(DIF::Interior *interior);
+
+	PLUGIN_API int get_normal_count(DIF::Interior *interior);
+
+	PLUGIN_API float *get_normals(DIF::Interior *interior);
+
+	PLUGIN_API int get_winding_count(DIF::Interior *interior);
+
+	PLUGIN_API unsigned int *get_windings(DIF::Interior *interior);
+
+	PLUGIN_API int get_plane_count(DIF::Interior *interior);
+
+	PLUGIN_API void get_planes(DIF::Interior *interior, int *normalIndices, float *distances);
+
+	PLUGIN_API int get_texgen_count(DIF::Interior *interior);
+
+	PLUGIN_API void get_texgens(DIF::Interior *interior, float *texgens);
+
+	PLUGIN_API int get_surface_count(DIF::Interior *interior);
+
+	PLUGIN_API void get_surfaces(DIF::Interior *interior, int *windingStarts, int *windingCounts, int *planeIndices, int *textureIndices, int *texGenIndices);
+
+	PLUGIN_API int get_material_count(DIF::Interior *interior);
+
+	PLUGIN_API const char *get_material_name(DIF::Interior *interior, int index);
+
+	PLUGIN_API void get_mesh_sizes(DIF::Interior *interior, int *vertexCount, int *triangleCount);
+
+	PLUGIN_API void extract_mesh(DIF::Interior *interior, float *positions, int *loopVertices, float *loopUVs, int *polyMaterials, float *polyNormals);
+
+	PLUGIN_API int get_path_follower_count(DIF::DIF *dif);
+
+	PLUGIN_API const char *get_path_follower_name(DIF::DIF *dif, int index);
+
+	PLUGIN_API const char *get_path_follower_datablock(DIF::DIF *dif, int index);
+
+	PLUGIN_API int get_path_follower_interior(DIF::DIF *dif, int index);
+
+	PLUGIN_API void get_path_follower_offset(DIF::DIF *dif, int index, float *offset);
+
+	PLUGIN_API DIF::Dictionary *get_path_follower_properties(DIF::DIF *dif, int index);
+
+	PLUGIN_API int get_path_follower_waypoint_count(DIF::DIF *dif, int index);
+
+	PLUGIN_API void get_path_follower_waypoints(DIF::DIF *dif, int index, float *positions, float *rotations, int *msToNext, int *smoothingTypes);
+
+	PLUGIN_API int get_game_entity_count(DIF::DIF *dif);
+
+	PLUGIN_API const char *get_game_entity_class(DIF::DIF *dif, int index);
+
+	PLUGIN_API const char *get_game_entity_datablock(DIF::DIF *dif, int index);
+
+	PLUGIN_API void get_game_entity_position(DIF::DIF *dif, int index, float *position);
+
+	PLUGIN_API DIF::Dictionary *get_game_entity_properties(DIF::DIF *dif, int index);
 }
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace DifBuilderLib
+{
+	// Streaming 64 bit hash for build cache keys, consumes input a word at a time
+	struct Hasher
+	{
+		uint64_t state;
+		uint64_t length = 0;
+
+		// A different seed gives an independent hash of the same input
+		explicit Hasher(uint64_t seed = 0x9E3779B97F4A7C15ULL) : state(seed)
+		{
+		}
+
+		void add(const void *data, size_t size)
+		{
+			const unsigned char *bytes = static_cast<const unsigned char *>(data);
+			size_t i = 0;
+			for (; i + 8 <= size; i += 8)
+			{
+				uint64_t word;
+				memcpy(&word, bytes + i, 8);
+				mix(word);
+			}
+
+			uint64_t tail = 0;
+			if (i < size)
+				memcpy(&tail, bytes + i, size - i);
+			mix(tail ^ ((uint64_t)(size - i) << 56));
+			length += size;
+		}
+
+		void add(const std::string &str)
+		{
+			add(str.data(), str.size());
+		}
+
+		template <typename T>
+		void addValue(const T &value)
+		{
+			add(&value, sizeof(T));
+		}
+
+		uint64_t finish() const
+		{
+			uint64_t h = state ^ length;
+			h ^= h >> 33;
+			h *= 0xFF51AFD7ED558CCDULL;
+			h ^= h >> 33;
+			h *= 0xC4CEB9FE1A85EC53ULL;
+			h ^= h >> 33;
+			return h;
+		}
+
+		std::string hex() const
+		{
+			static const char digits[] = "0123456789abcdef";
+			uint64_t h = finish();
+			std::string out(16, '0');
+			for (int i = 15; i >= 0; i--, h >>= 4)
+				out[i] = digits[h & 0xF];
+			return out;
+		}
+
+	private:
+		void mix(uint64_t word)
+		{
+			word *= 0x87C37B91114253D5ULL;
+			word = (word << 31) | (word >> 33);
+			word *= 0x4CF5AD432745937FULL;
+			state ^= word;
+			state = ((state << 27) | (state >> 37)) * 5 + 0x52DCE729;
+		}
+	};
+}
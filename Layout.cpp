@@ -0,0 +1,159 @@
+#include "Layout.h"
+#include "Remap.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace DifBuilderLib
+{
+	namespace
+	{
+		const U32 Unused = 0xFFFFFFFF;
+
+		// Spreads the low 10 bits of v three apart
+		uint32_t spreadBits(uint32_t v)
+		{
+			v &= 0x3FF;
+			v = (v | (v << 16)) & 0x030000FF;
+			v = (v | (v << 8)) & 0x0300F00F;
+			v = (v | (v << 4)) & 0x030C30C3;
+			v = (v | (v << 2)) & 0x09249249;
+			return v;
+		}
+
+		uint32_t mortonCode(const glm::vec3 &p, const glm::vec3 &min, const glm::vec3 &scale)
+		{
+			glm::vec3 n = (p - min) * scale;
+			uint32_t x = (uint32_t)std::min(std::max(n.x, 0.0f), 1023.0f);
+			uint32_t y = (uint32_t)std::min(std::max(n.y, 0.0f), 1023.0f);
+			uint32_t z = (uint32_t)std::min(std::max(n.z, 0.0f), 1023.0f);
+			return spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2);
+		}
+
+		// Null surface references are left alone, the null surfaces keep their order
+		void remapSurfaceReference(U32 &reference, const std::vector<U32> &remap)
+		{
+			if ((reference & NullSurfaceFlag) == 0 && reference < remap.size())
+				reference = remap[reference];
+		}
+
+		void useFirst(U32 index, std::vector<U32> &remap, U32 &next)
+		{
+			if (index < remap.size() && remap[index] == Unused)
+				remap[index] = next++;
+		}
+	}
+
+	void optimizeLayout(DIF::Interior &interior)
+	{
+		if (interior.point.empty() || interior.surface.empty())
+			return;
+
+		glm::vec3 min = interior.point[0], max = interior.point[0];
+		for (const glm::vec3 &p : interior.point)
+		{
+			min = glm::min(min, p);
+			max = glm::max(max, p);
+		}
+		glm::vec3 extent = max - min;
+		glm::vec3 scale(extent.x > 0.0f ? 1023.0f / extent.x : 0.0f, extent.y > 0.0f ? 1023.0f / extent.y : 0.0f, extent.z > 0.0f ? 1023.0f / extent.z : 0.0f);
+
+		// Surfaces: material first to keep render batches together, then space
+		size_t surfaceCount = interior.surface.size();
+		std::vector<uint64_t> keys(surfaceCount);
+		size_t windingTotal = 0;
+		for (size_t i = 0; i < surfaceCount; i++)
+		{
+			const DIF::Interior::Surface &surface = interior.surface[i];
+			glm::vec3 centroid(0.0f);
+			for (U32 j = 0; j < surface.windingCount; j++)
+				centroid += interior.point[interior.index[surface.windingStart + j]];
+			if (surface.windingCount > 0)
+				centroid /= (float)surface.windingCount;
+			keys[i] = ((uint64_t)surface.textureIndex << 32) | mortonCode(centroid, min, scale);
+			windingTotal += surface.windingCount;
+		}
+
+		std::vector<U32> order(surfaceCount);
+		for (size_t i = 0; i < surfaceCount; i++)
+			order[i] = (U32)i;
+		std::stable_sort(order.begin(), order.end(), [&](U32 a, U32 b) { return keys[a] < keys[b]; });
+
+		std::vector<U32> surfaceRemap(surfaceCount);
+		std::vector<DIF::Interior::Surface> surfaces(surfaceCount);
+		for (size_t i = 0; i < surfaceCount; i++)
+		{
+			surfaceRemap[order[i]] = (U32)i;
+			surfaces[i] = interior.surface[order[i]];
+		}
+
+		// Windings follow the surfaces, then come the null surface and portal windings. Unless some of them share
+		// windings and copying them would grow the array
+		for (const DIF::Interior::NullSurface &surface : interior.nullSurface)
+			windingTotal += surface.windingCount;
+		for (const DIF::Interior::WindingIndex &fan : interior.windingIndex)
+			windingTotal += fan.windingCount;
+		if (windingTotal <= interior.index.size())
+		{
+			std::vector<U32> windings;
+			windings.reserve(interior.index.size());
+			for (DIF::Interior::Surface &surface : surfaces)
+			{
+				U32 start = (U32)windings.size();
+				windings.insert(windings.end(), interior.index.begin() + surface.windingStart, interior.index.begin() + surface.windingStart + surface.windingCount);
+				surface.windingStart = start;
+			}
+			appendOtherWindings(interior, windings);
+			interior.index.swap(windings);
+		}
+		interior.surface.swap(surfaces);
+		remapSurfaceArrays(interior, surfaceRemap, surfaceCount);
+
+		for (U32 &index : interior.solidLeafSurface)
+			remapSurfaceReference(index, surfaceRemap);
+		for (U32 &index : interior.hullSurfaceIndex)
+			remapSurfaceReference(index, surfaceRemap);
+		for (U16 &index : interior.zoneSurface)
+			index = (U16)surfaceRemap[index];
+
+		// Points in order of first use by the windings, then hulls and poly lists, then whatever nothing refers to
+		std::vector<U32> pointRemap(interior.point.size(), Unused);
+		U32 next = 0;
+		for (U32 index : interior.index)
+			useFirst(index, pointRemap, next);
+		for (U32 index : interior.hullIndex)
+			useFirst(index, pointRemap, next);
+		for (U32 index : interior.polyListPointIndex)
+			useFirst(index, pointRemap, next);
+		for (size_t i = 0; i < pointRemap.size(); i++)
+			useFirst((U32)i, pointRemap, next);
+
+		std::vector<glm::vec3> points(interior.point.size());
+		for (size_t i = 0; i < pointRemap.size(); i++)
+			points[pointRemap[i]] = interior.point[i];
+		interior.point.swap(points);
+
+		if (interior.pointVisibility.size() == pointRemap.size())
+		{
+			std::vector<U8> visibility(pointRemap.size());
+			for (size_t i = 0; i < pointRemap.size(); i++)
+				visibility[pointRemap[i]] = interior.pointVisibility[i];
+			interior.pointVisibility.swap(visibility);
+		}
+
+		for (U32 &index : interior.index)
+			index = pointRemap[index];
+		for (U32 &index : interior.hullIndex)
+			index = pointRemap[index];
+		for (U32 &index : interior.polyListPointIndex)
+			index = pointRemap[index];
+	}
+
+	void optimizeLayout(DIF::DIF &dif)
+	{
+		for (DIF::Interior &interior : dif.interior)
+			optimizeLayout(interior);
+		for (DIF::Interior &interior : dif.subObject)
+			optimizeLayout(interior);
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include "DIFBuilder/DIFBuilder.hpp"
+
+namespace DifBuilderLib
+{
+	// Reorders surfaces by material and then along a Morton curve, lays out windings in surface order and
+	// points in order of first use, so geometry close in space is close in the arrays. The lightmap index arrays
+	// follow the surfaces. Each winding keeps its own point order, which is the strip the engine renders and
+	// builds collision fans from, so there is no strip or vertex cache reordering inside a surface
+	void optimizeLayout(DIF::Interior &interior);
+
+	void optimizeLayout(DIF::DIF &dif);
+}
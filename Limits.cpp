@@ -0,0 +1,59 @@
+#include "Limits.h"
+#include <algorithm>
+#include <cmath>
+
+namespace DifBuilderLib
+{
+	namespace
+	{
+		// Counts don't shrink quite linearly with the triangles, aim a little under the limit
+		const double SplitMargin = 1.1;
+
+		double usage(size_t count, U32 limit)
+		{
+			return (double)count / limit;
+		}
+
+		double limitUsage(const DIF::Interior &interior)
+		{
+			double worst = usage(interior.plane.size(), MaxPlanes);
+			worst = std::max(worst, usage(interior.bspNode.size(), MaxBSPNodes));
+			worst = std::max(worst, usage(interior.bspSolidLeaf.size(), MaxSolidLeaves));
+			worst = std::max(worst, usage(interior.surface.size(), MaxSurfaces));
+			worst = std::max(worst, usage(interior.point.size(), MaxPoints));
+			worst = std::max(worst, usage(interior.convexHull.size(), MaxConvexHulls));
+			worst = std::max(worst, usage(interior.texGenEq.size(), MaxTexGens));
+			return worst;
+		}
+	}
+
+	int startBudget()
+	{
+		return (int)std::min(MaxSurfaces, std::min(MaxBSPNodes, MaxSolidLeaves));
+	}
+
+	double limitUsage(const DIF::DIF &dif)
+	{
+		double worst = 0.0;
+		for (const DIF::Interior &interior : dif.interior)
+			worst = std::max(worst, limitUsage(interior));
+		for (const DIF::Interior &interior : dif.subObject)
+			worst = std::max(worst, limitUsage(interior));
+		return worst;
+	}
+
+	int splitBudget(const Builder &builder, const DIF::DIF &dif)
+	{
+		// Sub objects come from pathed interiors, splitting the static triangles does nothing for them
+		double worst = 0.0;
+		for (const DIF::Interior &interior : dif.interior)
+			worst = std::max(worst, limitUsage(interior));
+		if (worst <= 1.0 || builder.triangleCount() < 2)
+			return 0;
+
+		size_t faces = builder.triangleCount() * builder.facesPerTriangle();
+		size_t parts = std::max<size_t>(2, (size_t)std::ceil(worst * SplitMargin));
+		parts = std::min(parts, builder.triangleCount());
+		return (int)std::max<size_t>((faces + parts - 1) / parts, builder.facesPerTriangle());
+	}
+}
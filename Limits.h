@@ -0,0 +1,27 @@
+#pragma once
+#include "Builder.h"
+
+namespace DifBuilderLib
+{
+	// Largest counts an interior can have and still be written. Planes are referenced through 15 bits next to the
+	// flip flag, BSP children through 16 bits that also carry the leaf and solid flags, and surfaces, points,
+	// hulls and texgens through 16 bit indices in some tables.
+	const U32 MaxPlanes = 0x7FFF;
+	const U32 MaxBSPNodes = 0x3FFF;
+	const U32 MaxSolidLeaves = 0x3FFF;
+	const U32 MaxSurfaces = 0xFFFF;
+	const U32 MaxPoints = 0xFFFF;
+	const U32 MaxConvexHulls = 0xFFFF;
+	const U32 MaxTexGens = 0xFFFF;
+
+	// Face budget to first partition with. DIFBuilder adds about one surface, BSP node and solid leaf per face, so a
+	// chunk this size stays within the tightest of those limits. The others are left to splitBudget.
+	int startBudget();
+
+	// Largest ratio of count to limit over every interior and sub object of dif, above 1 means it can't be written
+	double limitUsage(const DIF::DIF &dif);
+
+	// Triangle budget to partition builder with when the interiors of dif, built from it, cross a format limit. The chunk count
+	// comes from how far over the limit it went, so one more round usually fits. 0 if dif fits or can't be split.
+	int splitBudget(const Builder &builder, const DIF::DIF &dif);
+}
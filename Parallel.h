@@ -0,0 +1,45 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace DifBuilderLib
+{
+	// Number of workers to use when the caller asks for threads <= 0
+	inline int defaultThreadCount()
+	{
+		unsigned int threads = std::thread::hardware_concurrency();
+		return threads == 0 ? 1 : (int)threads;
+	}
+
+	// Runs fn(i) for every i in [0, count) on up to threads workers, the calling thread included
+	template <typename F>
+	void parallelFor(int count, int threads, F fn)
+	{
+		if (threads <= 0)
+			threads = defaultThreadCount();
+		threads = std::min(threads, count);
+
+		if (threads <= 1)
+		{
+			for (int i = 0; i < count; i++)
+				fn(i);
+			return;
+		}
+
+		std::atomic<int> next(0);
+		auto worker = [&]() {
+			for (int i = next++; i < count; i = next++)
+				fn(i);
+		};
+
+		std::vector<std::thread> pool;
+		pool.reserve(threads - 1);
+		for (int i = 0; i < threads - 1; i++)
+			pool.emplace_back(worker);
+		worker();
+		for (std::thread &thread : pool)
+			thread.join();
+	}
+}
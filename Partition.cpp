@@ -0,0 +1,300 @@
+#include "Partition.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <iterator>
+
+namespace DifBuilderLib
+{
+	namespace
+	{
+		typedef std::vector<int>::iterator IndexIt;
+
+		const int BIN_COUNT = 16;
+
+		// Ranges larger than this recurse into their halves on separate threads
+		const std::ptrdiff_t PARALLEL_THRESHOLD = 32768;
+
+		// Threads every partition running in the process may add between them. Callers already run partitions
+		// on their own workers, so this keeps the total within the core count however the calls nest.
+		std::atomic<int> &spareThreads()
+		{
+			static std::atomic<int> spare(defaultThreadCount() - 1);
+			return spare;
+		}
+
+		// Holds one of the spare threads if asked to and one was free, and hands it back however the scope is left
+		struct SpareThread
+		{
+			bool taken = false;
+
+			explicit SpareThread(bool wanted)
+			{
+				std::atomic<int> &spare = spareThreads();
+				int available = wanted ? spare.load() : 0;
+				while (available > 0 && !taken)
+					taken = spare.compare_exchange_weak(available, available - 1);
+			}
+
+			~SpareThread()
+			{
+				if (taken)
+					spareThreads()++;
+			}
+
+			SpareThread(const SpareThread &) = delete;
+			SpareThread &operator=(const SpareThread &) = delete;
+		};
+
+		// The budget counts the faces handed to DIFBuilder, a double sided builder emits two per stored triangle
+		int storedBudget(const Builder &source, int maxTriangles)
+		{
+			if (maxTriangles <= 0)
+				return maxTriangles;
+			return std::max(1, maxTriangles / source.facesPerTriangle());
+		}
+
+		struct Partitioner
+		{
+			std::vector<glm::vec3> centroids;
+			std::vector<Bounds> bounds;
+			PartitionStrategy strategy;
+			int maxTriangles;
+
+			void measure(const TriangleStore &tris, size_t first, size_t count)
+			{
+				for (size_t i = first; i < first + count; i++)
+				{
+					Bounds triBounds;
+					for (int j = 0; j < 3; j++)
+						triBounds.extend(tris.point(i, j));
+					centroids.push_back((tris.point(i, 0) + tris.point(i, 1) + tris.point(i, 2)) / 3.0f);
+					bounds.push_back(triBounds);
+				}
+			}
+
+			std::vector<std::vector<int>> split(IndexIt begin, IndexIt end, int count)
+			{
+				if (count <= 1)
+				{
+					std::vector<int> chunk(begin, end);
+					std::sort(chunk.begin(), chunk.end());
+					return std::vector<std::vector<int>>(1, std::move(chunk));
+				}
+
+				int leftCount = count / 2;
+				IndexIt mid = strategy == PARTITION_BINNED ? binnedSplit(begin, end, leftCount, count - leftCount) : end;
+				if (mid == end)
+					mid = medianSplit(begin, end, leftCount, count);
+
+				std::vector<std::vector<int>> left;
+				std::vector<std::vector<int>> right;
+				SpareThread thread(strategy == PARTITION_BINNED && std::distance(begin, end) > PARALLEL_THRESHOLD);
+				if (thread.taken)
+				{
+					// The future's destructor waits for the task, so the thread is handed back only once it is done
+					std::future<std::vector<std::vector<int>>> leftTask = std::async(std::launch::async, [&]() { return split(begin, mid, leftCount); });
+					right = split(mid, end, count - leftCount);
+					left = leftTask.get();
+				}
+				else
+				{
+					left = split(begin, mid, leftCount);
+					right = split(mid, end, count - leftCount);
+				}
+
+				for (std::vector<int> &chunk : right)
+					left.push_back(std::move(chunk));
+				return left;
+			}
+
+			// Median split along the longest centroid axis, sized proportionally so every chunk
+			// ends up within one triangle of the others
+			IndexIt medianSplit(IndexIt begin, IndexIt end, int leftCount, int count)
+			{
+				Bounds centroidBounds;
+				for (IndexIt it = begin; it != end; ++it)
+					centroidBounds.extend(centroids[*it]);
+
+				glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+				int axis = 0;
+				if (extent.y > extent[axis])
+					axis = 1;
+				if (extent.z > extent[axis])
+					axis = 2;
+
+				IndexIt mid = begin + (std::distance(begin, end) * leftCount) / count;
+				std::nth_element(begin, mid, end, [&](int a, int b) { return centroids[a][axis] < centroids[b][axis]; });
+				return mid;
+			}
+
+			// Picks the bin boundary with the lowest surface area cost over all three axes, among the
+			// boundaries that leave both sides able to fit their share of chunks. Returns end if none does.
+			IndexIt binnedSplit(IndexIt begin, IndexIt end, int leftCount, int rightCount)
+			{
+				std::ptrdiff_t total = std::distance(begin, end);
+				std::ptrdiff_t minLeft = std::max<std::ptrdiff_t>(leftCount, total - (std::ptrdiff_t)rightCount * maxTriangles);
+				std::ptrdiff_t maxLeft = std::min<std::ptrdiff_t>(total - rightCount, (std::ptrdiff_t)leftCount * maxTriangles);
+
+				Bounds centroidBounds;
+				for (IndexIt it = begin; it != end; ++it)
+					centroidBounds.extend(centroids[*it]);
+
+				float bestCost = std::numeric_limits<float>::max();
+				int bestAxis = -1;
+				int bestBin = 0;
+
+				for (int axis = 0; axis < 3; axis++)
+				{
+					float lo = centroidBounds.min[axis];
+					float hi = centroidBounds.max[axis];
+					if (hi <= lo)
+						continue;
+
+					Bounds binBounds[BIN_COUNT];
+					std::ptrdiff_t binCounts[BIN_COUNT] = {};
+					float scale = BIN_COUNT / (hi - lo);
+					for (IndexIt it = begin; it != end; ++it)
+					{
+						int bin = std::min(BIN_COUNT - 1, (int)((centroids[*it][axis] - lo) * scale));
+						binCounts[bin]++;
+						binBounds[bin].extend(bounds[*it]);
+					}
+
+					// Sweep from the right to get the cost of every suffix, then from the left
+					float rightArea[BIN_COUNT];
+					Bounds accum;
+					for (int i = BIN_COUNT - 1; i > 0; i--)
+					{
+						accum.extend(binBounds[i]);
+						rightArea[i] = accum.area();
+					}
+
+					Bounds leftBounds;
+					std::ptrdiff_t leftTris = 0;
+					for (int i = 0; i < BIN_COUNT - 1; i++)
+					{
+						leftBounds.extend(binBounds[i]);
+						leftTris += binCounts[i];
+						if (leftTris < minLeft || leftTris > maxLeft)
+							continue;
+
+						float cost = leftBounds.area() * leftTris + rightArea[i + 1] * (total - leftTris);
+						if (cost < bestCost)
+						{
+							bestCost = cost;
+							bestAxis = axis;
+							bestBin = i + 1;
+						}
+					}
+				}
+
+				if (bestAxis < 0)
+					return end;
+
+				float lo = centroidBounds.min[bestAxis];
+				float scale = BIN_COUNT / (centroidBounds.max[bestAxis] - lo);
+				return std::partition(begin, end, [&](int tri) { return std::min(BIN_COUNT - 1, (int)((centroids[tri][bestAxis] - lo) * scale)) < bestBin; });
+			}
+		};
+	}
+
+	int partitionCount(const Builder &source, int maxTriangles)
+	{
+		maxTriangles = storedBudget(source, maxTriangles);
+		if (maxTriangles <= 0 || source.triangleCount() == 0)
+			return 1;
+		return (int)((source.triangleCount() + maxTriangles - 1) / maxTriangles);
+	}
+
+	std::vector<Builder *> partition(Builder &source, int maxTriangles, PartitionStrategy strategy)
+	{
+		Partitioner partitioner;
+		partitioner.strategy = strategy;
+		partitioner.maxTriangles = storedBudget(source, maxTriangles);
+		partitioner.centroids.reserve(source.triangleCount());
+		partitioner.bounds.reserve(source.triangleCount());
+
+		// A streaming source moves its triangles to the spill file first so the chunks take only their record ids,
+		// rather than holding a copy of every triangle next to the source. Otherwise they are copied.
+		if (source.spillThreshold > 0)
+			source.spillTriangles(true);
+
+		// From a page that cannot be read on everything is measured at the origin, building the chunks fails anyway
+		source.forEachPage(0, [&](const TriangleStore &page, size_t first, size_t count)
+		{
+			partitioner.measure(page, first, count);
+			return true;
+		});
+		partitioner.centroids.resize(source.triangleCount(), glm::vec3(0.0f));
+		partitioner.bounds.resize(source.triangleCount());
+
+		size_t spilledCount = source.spilled.size();
+		std::vector<int> order(source.triangleCount());
+		for (size_t i = 0; i < order.size(); i++)
+			order[i] = (int)i;
+
+		std::vector<std::vector<int>> chunks = partitioner.split(order.begin(), order.end(), partitionCount(source, maxTriangles));
+		std::vector<int>().swap(order);
+		std::vector<glm::vec3>().swap(partitioner.centroids);
+
+		// The split state goes before the triangles are copied, so it does not add to the peak of an in memory source
+		std::vector<Bounds> chunkBounds(chunks.size());
+		for (size_t i = 0; i < chunks.size(); i++)
+		{
+			for (int tri : chunks[i])
+				chunkBounds[i].extend(partitioner.bounds[tri]);
+		}
+		std::vector<Bounds>().swap(partitioner.bounds);
+
+		std::vector<Builder *> builders;
+		builders.reserve(chunks.size());
+		for (size_t i = 0; i < chunks.size(); i++)
+		{
+			std::vector<int> &chunk = chunks[i];
+			Builder *builder = new Builder();
+			builder->materials = source.materials;
+			builder->materialIds = source.materialIds;
+			builder->weld = source.weld;
+			builder->optimizeLayout = source.optimizeLayout;
+			builder->mergeSurfaces = source.mergeSurfaces;
+			builder->offset = source.offset;
+			builder->faceFlags = source.faceFlags;
+			builder->cacheDir = source.cacheDir;
+			builder->spillDir = source.spillDir;
+			builder->spillThreshold = source.spillThreshold;
+			builder->spill = source.spill;
+			builder->progress = source.progress;
+			builder->progressUser = source.progressUser;
+
+			std::vector<int> resident;
+			for (int tri : chunk)
+			{
+				if ((size_t)tri < spilledCount)
+					builder->spilled.push_back(source.spilled[tri]);
+				else
+					resident.push_back(tri - (int)spilledCount);
+			}
+			std::vector<int>().swap(chunk);
+			source.triangles.extract(resident, builder->triangles);
+			builder->bounds = chunkBounds[i];
+			builders.push_back(builder);
+		}
+
+		if (!builders.empty())
+		{
+			for (const auto &pathed : source.pathedInputs)
+				builders[0]->addPathedInterior(pathed.first, pathed.second);
+			for (const DIF::DIFBuilder::Trigger &trigger : source.triggerInputs)
+				builders[0]->addTrigger(trigger);
+		}
+
+		source.triangles.release();
+		std::vector<U32>().swap(source.spilled);
+		source.spill.reset();
+		source.submittedTriangles = 0;
+		source.bounds = Bounds();
+		return builders;
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "Builder.h"
+#include <vector>
+
+namespace DifBuilderLib
+{
+	enum PartitionStrategy
+	{
+		// Median split of the centroids along the longest axis
+		PARTITION_MEDIAN = 0,
+		// Binned surface area heuristic over all three axes, recursing into both halves in parallel while cores are free
+		PARTITION_BINNED = 1,
+	};
+
+	// Number of chunks partition() splits source into for a given triangle budget
+	int partitionCount(const Builder &source, int maxTriangles);
+
+	// Moves the triangles of source into spatially compact chunks of at most maxTriangles each
+	// and releases its triangle storage. A streaming source moves its triangles to the spill file first and the chunks
+	// share it, only holding record ids; otherwise, or if the file cannot be created, they are copied into the chunks.
+	// Every chunk is a new Builder, owned by the caller, with the triangles in submission order. Pathed interiors and
+	// triggers added to source are added to the first chunk too. The split itself keeps a centroid, bounds and index
+	// of every triangle in memory, about 40 bytes each, streaming or not, and frees them before the copy.
+	std::vector<Builder *> partition(Builder &source, int maxTriangles, PartitionStrategy strategy = PARTITION_MEDIAN);
+}
@@ -0,0 +1,598 @@
+#include "Reader.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <streambuf>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace DifBuilderLib
+{
+	namespace
+	{
+		// Read only view of a whole file, unmapped on destruction
+		class MappedFile
+		{
+		public:
+			explicit MappedFile(const std::string &path)
+			{
+#ifdef _WIN32
+				int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, NULL, 0);
+				std::wstring widePath(length, L'\0');
+				MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &widePath[0], length);
+
+				HANDLE file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+				if (file == INVALID_HANDLE_VALUE)
+					return;
+				LARGE_INTEGER size;
+				if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+				{
+					HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+					if (mapping != NULL)
+					{
+						mData = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+						if (mData != NULL)
+							mSize = (size_t)size.QuadPart;
+						CloseHandle(mapping);
+					}
+				}
+				CloseHandle(file);
+#else
+				int fd = open(path.c_str(), O_RDONLY);
+				if (fd < 0)
+					return;
+				struct stat st;
+				if (fstat(fd, &st) == 0 && st.st_size > 0)
+				{
+					void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+					if (data != MAP_FAILED)
+					{
+						madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+						mData = (const char *)data;
+						mSize = (size_t)st.st_size;
+					}
+				}
+				close(fd);
+#endif
+			}
+
+			~MappedFile()
+			{
+				if (mData == NULL)
+					return;
+#ifdef _WIN32
+				UnmapViewOfFile(mData);
+#else
+				munmap(const_cast<char *>(mData), mSize);
+#endif
+			}
+
+			MappedFile(const MappedFile &) = delete;
+			MappedFile &operator=(const MappedFile &) = delete;
+
+			const char *data() const { return mData; }
+			size_t size() const { return mSize; }
+
+		private:
+			const char *mData = NULL;
+			size_t mSize = 0;
+		};
+
+		// streambuf reading straight out of memory, seekable so the DIF reader can skip around
+		class MemoryStreamBuf : public std::streambuf
+		{
+		public:
+			MemoryStreamBuf(const char *data, size_t size)
+			{
+				char *begin = const_cast<char *>(data);
+				setg(begin, begin, begin + size);
+			}
+
+		protected:
+			pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+			{
+				if (!(which & std::ios_base::in))
+					return pos_type(off_type(-1));
+
+				off_type base = dir == std::ios_base::beg ? 0 : dir == std::ios_base::cur ? gptr() - eback() : egptr() - eback();
+				off_type target = base + off;
+				if (target < 0 || target > egptr() - eback())
+					return pos_type(off_type(-1));
+
+				setg(eback(), eback() + target, egptr());
+				return pos_type(target);
+			}
+
+			pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+			{
+				return seekoff(off_type(pos), std::ios_base::beg, which);
+			}
+		};
+
+		// Runs of memory read one after the other as a single seekable stream, so a DIF can be parsed with sections
+		// cut out of it without copying the rest
+		class ChainStreamBuf : public std::streambuf
+		{
+		public:
+			// Merges a run with the one before it when they are contiguous
+			void append(const char *data, size_t size)
+			{
+				if (size == 0)
+					return;
+				if (!mPieces.empty() && mPieces.back().data + mPieces.back().size == data)
+				{
+					mPieces.back().size += size;
+					return;
+				}
+				mPieces.push_back({data, size, mSize});
+				mSize += size;
+			}
+
+			// Call once every run is appended
+			void start()
+			{
+				enter(0, 0);
+			}
+
+		protected:
+			int_type underflow() override
+			{
+				if (gptr() < egptr())
+					return traits_type::to_int_type(*gptr());
+				if (mCurrent + 1 >= mPieces.size())
+					return traits_type::eof();
+				enter(mCurrent + 1, 0);
+				return traits_type::to_int_type(*gptr());
+			}
+
+			pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+			{
+				if (!(which & std::ios_base::in))
+					return pos_type(off_type(-1));
+
+				off_type current = mPieces.empty() ? 0 : (off_type)mPieces[mCurrent].start + (gptr() - eback());
+				off_type base = dir == std::ios_base::beg ? 0 : dir == std::ios_base::cur ? current : (off_type)mSize;
+				off_type target = base + off;
+				if (target < 0 || target > (off_type)mSize)
+					return pos_type(off_type(-1));
+
+				// The last run starting at or before target, the end maps to the end of the last run
+				size_t index = 0;
+				while (index + 1 < mPieces.size() && mPieces[index + 1].start <= (size_t)target)
+					index++;
+				enter(index, (size_t)target - (mPieces.empty() ? 0 : mPieces[index].start));
+				return pos_type(target);
+			}
+
+			pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+			{
+				return seekoff(off_type(pos), std::ios_base::beg, which);
+			}
+
+		private:
+			struct Piece
+			{
+				const char *data;
+				size_t size;
+				size_t start;
+			};
+
+			void enter(size_t index, size_t offset)
+			{
+				mCurrent = index;
+				if (mPieces.empty())
+					return;
+				char *begin = const_cast<char *>(mPieces[index].data);
+				setg(begin, begin + offset, begin + mPieces[index].size);
+			}
+
+			std::vector<Piece> mPieces;
+			size_t mCurrent = 0;
+			size_t mSize = 0;
+		};
+
+		// Stands in for a skipped array
+		const char EmptyArray[4] = {0, 0, 0, 0};
+
+		// Follows the layout the DIF reader parses, only far enough to know how long everything is
+		class DifScanner
+		{
+		public:
+			DifScanner(const char *data, size_t size) : mData(data), mSize(size)
+			{
+			}
+
+			bool scan(DifLayout &layout)
+			{
+				U32 difVersion;
+				U8 preview;
+				if (!read(difVersion) || !read(preview) || preview != 0)
+					return false;
+
+				layout.interiorsBegin = mPos;
+				if (!scanInteriors(layout.interiors))
+					return false;
+				layout.subObjectsBegin = mPos;
+				if (!scanInteriors(layout.subObjects))
+					return false;
+				layout.end = mPos;
+				return true;
+			}
+
+		private:
+			enum InteriorType
+			{
+				TYPE_UNKNOWN,
+				TYPE_TGEA,
+				TYPE_TGE
+			};
+
+			template <typename T>
+			bool read(T &value)
+			{
+				if (mSize - mPos < sizeof(T))
+					return false;
+				memcpy(&value, mData + mPos, sizeof(T));
+				mPos += sizeof(T);
+				return true;
+			}
+
+			bool skip(uint64_t bytes)
+			{
+				if (mSize - mPos < bytes)
+					return false;
+				mPos += (size_t)bytes;
+				return true;
+			}
+
+			bool skipArray(size_t elementSize, U32 *count = NULL)
+			{
+				U32 length;
+				if (!read(length))
+					return false;
+				if (count != NULL)
+					*count = length;
+				return skip((uint64_t)length * elementSize);
+			}
+
+			// An array whose count may carry the 0x80000000 flag and a parameter, which usually shrink its elements
+			// from 4 bytes to 2. elementSize(flagged, param) gives their size.
+			template <typename F>
+			bool skipFlaggedArray(F elementSize, U32 *count = NULL)
+			{
+				U32 length;
+				U32 param = 0;
+				if (!read(length))
+					return false;
+				bool flagged = (length & 0x80000000) != 0;
+				length &= 0x7FFFFFFF;
+				if (flagged && !read(param))
+					return false;
+				if (count != NULL)
+					*count = length;
+				return skip((uint64_t)length * elementSize(flagged, param));
+			}
+
+			// By chunk lengths, up to and including IEND
+			bool skipPNG()
+			{
+				static const unsigned char Signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+				if (mSize - mPos < sizeof(Signature) || memcmp(mData + mPos, Signature, sizeof(Signature)) != 0)
+					return false;
+				mPos += sizeof(Signature);
+				for (;;)
+				{
+					if (mSize - mPos < 8)
+						return false;
+					const unsigned char *header = (const unsigned char *)mData + mPos;
+					uint64_t length = ((uint64_t)header[0] << 24) | ((uint64_t)header[1] << 16) | ((uint64_t)header[2] << 8) | header[3];
+					bool end = memcmp(header + 4, "IEND", 4) == 0;
+					if (!skip(8 + length + 4))
+						return false;
+					if (end)
+						return true;
+				}
+			}
+
+			bool scanInteriors(std::vector<InteriorSpan> &spans)
+			{
+				U32 count;
+				if (!read(count) || count > mSize - mPos)
+					return false;
+				spans.resize(count);
+				for (InteriorSpan &span : spans)
+				{
+					if (!scanInterior(span))
+						return false;
+				}
+				return true;
+			}
+
+			bool scanSurfaces()
+			{
+				U32 count;
+				if (!read(count) || count > mSize - mPos)
+					return false;
+				for (U32 i = 0; i < count; i++)
+				{
+					U32 windingStart;
+					U32 windingCount;
+					U8 shortCount;
+					U16 planeIndex;
+					U16 textureIndex;
+					U32 texGenIndex;
+					if (!read(windingStart))
+						return false;
+					if (mVersion >= 13 ? !read(windingCount) : !read(shortCount))
+						return false;
+					if (mVersion < 13)
+						windingCount = shortCount;
+					if (!read(planeIndex) || !read(textureIndex) || !read(texGenIndex))
+						return false;
+
+					// The checks the reader uses to tell the two surface layouts apart
+					if (windingStart >= mWindings || (uint64_t)windingStart + windingCount > mWindings || (U32)(planeIndex & 0x7FFF) >= mPlanes || textureIndex >= mMaterials || texGenIndex >= mTexGens)
+						return false;
+
+					// Flags, fan mask, lightmap final word and texgen, light count and state start, then the map rect
+					if (!skip(1 + 4 + 2 + 4 + 4 + 2 + 4 + (mVersion >= 13 ? 16 : 4)))
+						return false;
+					if (mType == TYPE_TGEA && !skip(1 + (mVersion >= 2 && mVersion <= 5 ? 4 : 0)))
+						return false;
+				}
+				return true;
+			}
+
+			bool scanInterior(InteriorSpan &span)
+			{
+				span.begin = mPos;
+				if (mType == TYPE_UNKNOWN)
+					mType = TYPE_TGEA;
+				auto halfIfFlagged = [](bool flagged, U32) { return flagged ? (size_t)2 : (size_t)4; };
+				auto alwaysHalf = [](bool, U32) { return (size_t)2; };
+
+				// Detail level, min pixels, bounding box and sphere, alarm state, light state entries
+				if (!read(mVersion) || !skip(4 + 4 + 24 + 16 + 1 + 4))
+					return false;
+				if (!skipArray(12) || !skipArray(6, &mPlanes) || !skipArray(12))
+					return false;
+				if (mVersion != 4 && !skipArray(1))
+					return false;
+				if (!skipArray(32, &mTexGens) || !skipArray(mVersion >= 14 ? 10 : 6) || !skipArray(6))
+					return false;
+
+				U8 materialListVersion;
+				if (!read(materialListVersion) || !read(mMaterials))
+					return false;
+				for (U32 i = 0; i < mMaterials; i++)
+				{
+					U8 length;
+					if (!read(length) || !skip(length))
+						return false;
+				}
+
+				if (!skipFlaggedArray([](bool flagged, U32 param) { return flagged && param > 0 ? (size_t)2 : (size_t)4; }, &mWindings) || !skipArray(8))
+					return false;
+				if (mVersion >= 12 && !skipArray(16))
+					return false;
+				if (!skipArray(mVersion >= 12 ? 20 : 12) || !skipFlaggedArray(alwaysHalf))
+					return false;
+				if (mVersion >= 12 && !skipArray(4))
+					return false;
+				if (!skipFlaggedArray(alwaysHalf) || !skipArray(12))
+					return false;
+
+				size_t surfaces = mPos;
+				if (!scanSurfaces())
+				{
+					if (mType == TYPE_TGEA)
+						mType = TYPE_TGE;
+					mPos = surfaces;
+					if (!scanSurfaces())
+						return false;
+				}
+
+				if (mVersion >= 2 && mVersion <= 5)
+				{
+					if (!skipArray(mVersion >= 3 ? 24 : 16))
+						return false;
+					if (mVersion >= 4 && (!skipArray(12) || !skipFlaggedArray([](bool flagged, U32 param) { return flagged && param == 0 ? (size_t)1 : (size_t)2; })))
+						return false;
+				}
+
+				// Normal and alarm lightmap indices per surface, then the null surfaces
+				if (mVersion == 4 ? !skipArray(1) : !skipArray(mVersion >= 13 ? 4 : 1) || !skipArray(mVersion >= 13 ? 4 : 1))
+					return false;
+				if (!skipArray(mVersion >= 13 ? 11 : 8))
+					return false;
+
+				span.lightMapBegin = mPos;
+				if (mVersion != 4)
+				{
+					U32 lightMaps;
+					if (!read(lightMaps))
+						return false;
+					for (U32 i = 0; i < lightMaps; i++)
+					{
+						if (!skipPNG() || (mType == TYPE_TGEA && !skipPNG()) || !skip(1))
+							return false;
+					}
+				}
+				span.lightMapEnd = mPos;
+
+				// Solid leaf surfaces, animated lights, light states
+				if (!skipFlaggedArray(halfIfFlagged) || !skipArray(16) || !skipArray(13))
+					return false;
+				if (mVersion != 4)
+				{
+					// State data, its buffer behind a count and flags, the name buffer and the sub object count
+					U32 length;
+					U32 flags;
+					if (!skipArray(12) || !read(length) || !read(flags) || !skip(length) || !skipArray(1) || !skip(4))
+						return false;
+				}
+
+				// Convex hulls and their emit strings, hull indices, planes, emit string and surface indices, then
+				// the poly list planes, points and strings
+				if (!skipArray(mVersion >= 12 ? 53 : 52) || !skipArray(1))
+					return false;
+				if (!skipFlaggedArray(halfIfFlagged) || !skipFlaggedArray(alwaysHalf) || !skipFlaggedArray(halfIfFlagged) || !skipFlaggedArray(halfIfFlagged))
+					return false;
+				if (!skipFlaggedArray(alwaysHalf) || !skipFlaggedArray(halfIfFlagged) || !skipArray(1))
+					return false;
+
+				// 256 coord bins, their indices and the bin mode
+				if (!skip(256 * 8) || !skipFlaggedArray(alwaysHalf) || !skip(4))
+					return false;
+
+				if (mVersion != 4)
+				{
+					// Base and alarm ambient colours
+					if (!skip(8))
+						return false;
+					if (mVersion >= 10 && !skip(4))
+						return false;
+					if (mVersion >= 11 ? !skipArray(12) || !skipArray(12) || !skipArray(4) : !skip(12))
+						return false;
+					U32 extendedLightMapData;
+					if (!read(extendedLightMapData) || (extendedLightMapData > 0 && !skip(8)))
+						return false;
+				}
+
+				span.end = mPos;
+				return true;
+			}
+
+			const char *mData;
+			size_t mSize;
+			size_t mPos = 0;
+
+			// Carried from one interior to the next, as the reader does
+			InteriorType mType = TYPE_UNKNOWN;
+
+			// Of the interior being scanned
+			U32 mVersion = 0;
+			U32 mPlanes = 0;
+			U32 mTexGens = 0;
+			U32 mMaterials = 0;
+			U32 mWindings = 0;
+		};
+
+		void appendInteriors(ChainStreamBuf &buf, const char *data, size_t begin, const std::vector<InteriorSpan> &spans, bool keep, bool keepLightMaps)
+		{
+			if (!keep)
+			{
+				buf.append(EmptyArray, sizeof(EmptyArray));
+				return;
+			}
+			buf.append(data + begin, sizeof(U32));
+			for (const InteriorSpan &span : spans)
+			{
+				if (keepLightMaps || span.lightMapBegin == span.lightMapEnd)
+				{
+					buf.append(data + span.begin, span.end - span.begin);
+					continue;
+				}
+				buf.append(data + span.begin, span.lightMapBegin - span.begin);
+				buf.append(EmptyArray, sizeof(EmptyArray));
+				buf.append(data + span.lightMapEnd, span.end - span.lightMapEnd);
+			}
+		}
+	}
+
+	bool scanDif(const char *data, size_t size, DifLayout &layout)
+	{
+		layout = DifLayout();
+		DifScanner scanner(data, size);
+		return scanner.scan(layout);
+	}
+
+	bool readDifBuffer(const char *data, size_t size, DIF::DIF &dif)
+	{
+		MemoryStreamBuf buf(data, size);
+		std::istream stream(&buf);
+		DIF::Version ver;
+		return dif.read(stream, ver);
+	}
+
+	bool readDif(const std::string &path, DIF::DIF &dif)
+	{
+		MappedFile file(path);
+		if (file.data() == NULL)
+			return false;
+		return readDifBuffer(file.data(), file.size(), dif);
+	}
+
+	bool readDifWithHeader(const std::string &path, const void *header, size_t headerSize, DIF::DIF &dif)
+	{
+		MappedFile file(path);
+		if (file.data() == NULL || file.size() < headerSize || memcmp(file.data(), header, headerSize) != 0)
+			return false;
+		return readDifBuffer(file.data() + headerSize, file.size() - headerSize, dif);
+	}
+
+	bool readDifSections(const std::string &path, int sections, DIF::DIF &dif)
+	{
+		const int Skippable = DIF_SECTION_INTERIORS | DIF_SECTION_SUB_OBJECTS | DIF_SECTION_LIGHTMAPS;
+		MappedFile file(path);
+		if (file.data() == NULL)
+			return false;
+
+		DifLayout layout;
+		if ((sections & Skippable) != Skippable && scanDif(file.data(), file.size(), layout))
+		{
+			ChainStreamBuf buf;
+			buf.append(file.data(), layout.interiorsBegin);
+			bool keepLightMaps = (sections & DIF_SECTION_LIGHTMAPS) != 0;
+			appendInteriors(buf, file.data(), layout.interiorsBegin, layout.interiors, (sections & DIF_SECTION_INTERIORS) != 0, keepLightMaps);
+			appendInteriors(buf, file.data(), layout.subObjectsBegin, layout.subObjects, (sections & DIF_SECTION_SUB_OBJECTS) != 0, keepLightMaps);
+			buf.append(file.data() + layout.end, file.size() - layout.end);
+			buf.start();
+
+			std::istream stream(&buf);
+			DIF::Version ver;
+			if (dif.read(stream, ver))
+			{
+				keepSections(dif, sections);
+				return true;
+			}
+			dif = DIF::DIF();
+		}
+
+		if (!readDifBuffer(file.data(), file.size(), dif))
+			return false;
+		keepSections(dif, sections);
+		return true;
+	}
+
+	void keepSections(DIF::DIF &dif, int sections)
+	{
+		if (!(sections & DIF_SECTION_INTERIORS))
+			std::vector<DIF::Interior>().swap(dif.interior);
+		if (!(sections & DIF_SECTION_SUB_OBJECTS))
+			std::vector<DIF::Interior>().swap(dif.subObject);
+		if (!(sections & DIF_SECTION_PATH_FOLLOWERS))
+			std::vector<DIF::InteriorPathFollower>().swap(dif.interiorPathFollower);
+		if (!(sections & DIF_SECTION_GAME_ENTITIES))
+			std::vector<DIF::GameEntity>().swap(dif.gameEntity);
+		if (!(sections & DIF_SECTION_TRIGGERS))
+			std::vector<DIF::Trigger>().swap(dif.trigger);
+
+		if (!(sections & DIF_SECTION_LIGHTMAPS))
+		{
+			for (DIF::Interior &interior : dif.interior)
+				std::vector<DIF::Interior::LightMap>().swap(interior.lightMap);
+			for (DIF::Interior &interior : dif.subObject)
+				std::vector<DIF::Interior::LightMap>().swap(interior.lightMap);
+		}
+	}
+}
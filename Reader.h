@@ -0,0 +1,63 @@
+#pragma once
+#include "DIFBuilder/DIFBuilder.hpp"
+#include <string>
+#include <vector>
+
+namespace DifBuilderLib
+{
+	// Sections of a read DIF, for read_dif_filtered
+	enum DifSection
+	{
+		DIF_SECTION_INTERIORS = 1,
+		DIF_SECTION_SUB_OBJECTS = 2,
+		DIF_SECTION_PATH_FOLLOWERS = 4,
+		DIF_SECTION_GAME_ENTITIES = 8,
+		DIF_SECTION_TRIGGERS = 16,
+		DIF_SECTION_LIGHTMAPS = 32,
+		DIF_SECTION_ALL = 63
+	};
+
+	// Reads a DIF from a UTF-8 path through a read only memory mapping of the file. The whole file is parsed,
+	// lightmaps included; the mapping only saves copying the file into a stream buffer first. readDifSections
+	// skips what is not needed.
+	bool readDif(const std::string &path, DIF::DIF &dif);
+
+	// Reads a DIF from size bytes in memory, as serialize writes them
+	bool readDifBuffer(const char *data, size_t size, DIF::DIF &dif);
+
+	// readDif for files that start with the headerSize bytes of header ahead of the DIF, false if they do not
+	bool readDifWithHeader(const std::string &path, const void *header, size_t headerSize, DIF::DIF &dif);
+
+	// Frees every section not in sections after parsing, lightmaps are dropped from interiors and sub objects
+	// alike. On its own this lowers the memory a loaded DIF holds on to, not the time it takes to read.
+	void keepSections(DIF::DIF &dif, int sections);
+
+	// Byte offsets of an interior in a DIF file, and of its lightmap array (count included) within it
+	struct InteriorSpan
+	{
+		size_t begin = 0;
+		size_t lightMapBegin = 0;
+		size_t lightMapEnd = 0;
+		size_t end = 0;
+	};
+
+	// Where the interior and sub object arrays of a DIF file lie, each starting at its count
+	struct DifLayout
+	{
+		size_t interiorsBegin = 0;
+		std::vector<InteriorSpan> interiors;
+		size_t subObjectsBegin = 0;
+		std::vector<InteriorSpan> subObjects;
+		size_t end = 0;
+	};
+
+	// Walks the interiors and sub objects of a DIF file by their array counts and element sizes, lightmaps by their
+	// PNG chunk lengths, without parsing them. Surfaces are told apart as TGEA or TGE the way the reader does.
+	// False for anything it does not follow, such as an embedded preview bitmap or a count running past the end.
+	bool scanDif(const char *data, size_t size, DifLayout &layout);
+
+	// readDif and keepSections in one. Interiors, sub objects and lightmaps left out of sections are skipped by
+	// scanDif before the reader sees them; if the file cannot be scanned, or the rest then fails to parse, it is
+	// read whole and filtered after.
+	bool readDifSections(const std::string &path, int sections, DIF::DIF &dif);
+}
@@ -0,0 +1,58 @@
+#include "Remap.h"
+#include <algorithm>
+
+namespace DifBuilderLib
+{
+	namespace
+	{
+		template <typename W>
+		void appendWinding(const std::vector<U32> &index, W &winding, std::vector<U32> &windings)
+		{
+			size_t start = windings.size();
+			size_t begin = std::min(index.size(), (size_t)winding.windingStart);
+			size_t end = std::min(index.size(), begin + winding.windingCount);
+			windings.insert(windings.end(), index.begin() + begin, index.begin() + end);
+			winding.windingStart = (U32)start;
+		}
+
+		template <typename T>
+		void remapArray(std::vector<T> &values, const std::vector<U32> &remap, size_t count)
+		{
+			if (values.size() != remap.size())
+				return;
+
+			std::vector<T> remapped(count);
+			std::vector<bool> set(count, false);
+			for (size_t i = 0; i < remap.size(); i++)
+			{
+				U32 to = remap[i];
+				if (to < count && !set[to])
+				{
+					remapped[to] = values[i];
+					set[to] = true;
+				}
+			}
+			values.swap(remapped);
+		}
+	}
+
+	void appendOtherWindings(DIF::Interior &interior, std::vector<U32> &windings)
+	{
+		for (DIF::Interior::NullSurface &surface : interior.nullSurface)
+			appendWinding(interior.index, surface, windings);
+		for (DIF::Interior::WindingIndex &fan : interior.windingIndex)
+			appendWinding(interior.index, fan, windings);
+	}
+
+	void remapSurfaceArrays(DIF::Interior &interior, const std::vector<U32> &remap, size_t surfaceCount)
+	{
+		remapArray(interior.normalLMapIndex, remap, surfaceCount);
+		remapArray(interior.alarmLMapIndex, remap, surfaceCount);
+	}
+
+	bool hasLightMap(const DIF::Interior &interior, size_t surface)
+	{
+		size_t maps = interior.lightMap.size();
+		return (surface < interior.normalLMapIndex.size() && (size_t)interior.normalLMapIndex[surface] < maps) || (surface < interior.alarmLMapIndex.size() && (size_t)interior.alarmLMapIndex[surface] < maps);
+	}
+}
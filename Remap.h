@@ -0,0 +1,20 @@
+#pragma once
+#include "DIFBuilder/DIFBuilder.hpp"
+#include <vector>
+
+namespace DifBuilderLib
+{
+	// Set on solid leaf and hull surface references that point into the null surfaces instead
+	const U32 NullSurfaceFlag = 0x80000000;
+
+	// For passes that rebuild the winding array from their surfaces: appends the windings of the null surfaces and
+	// of the portal tri fans, read from the interior's current index array, and points them at their copies
+	void appendOtherWindings(DIF::Interior &interior, std::vector<U32> &windings);
+
+	// Moves the per surface arrays, the lightmap indices, from old to new surface numbers through remap. Where
+	// several surfaces map to one the first keeps its value. Arrays not sized to remap are left alone
+	void remapSurfaceArrays(DIF::Interior &interior, const std::vector<U32> &remap, size_t surfaceCount);
+
+	// Whether a lightmap is placed on the surface, in the normal or the alarm state
+	bool hasLightMap(const DIF::Interior &interior, size_t surface);
+}
@@ -0,0 +1,249 @@
+#include "Spill.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace DifBuilderLib
+{
+	namespace
+	{
+		// A triangle expanded with its corners in DIFBuilder winding, 76 bytes
+		struct SpillRecord
+		{
+			float points[9];
+			float uvs[6];
+			float normal[3];
+			int32_t material;
+		};
+
+		// Records written per call
+		const size_t WriteBatch = 4096;
+
+		std::atomic<unsigned> spillCounter(0);
+
+		std::string spillName()
+		{
+#ifdef _WIN32
+			unsigned long process = GetCurrentProcessId();
+#else
+			unsigned long process = (unsigned long)getpid();
+#endif
+			return "difbuilder-" + std::to_string(process) + "-" + std::to_string(spillCounter++) + ".spill";
+		}
+
+		void pack(const TriangleStore &store, size_t tri, SpillRecord &record)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				const glm::vec3 &point = store.point(tri, i);
+				const glm::vec2 &uv = store.uvs[store.uvIndices[tri * 3 + i]];
+				record.points[i * 3] = point.x;
+				record.points[i * 3 + 1] = point.y;
+				record.points[i * 3 + 2] = point.z;
+				record.uvs[i * 2] = uv.x;
+				record.uvs[i * 2 + 1] = uv.y;
+			}
+			record.normal[0] = store.normals[tri].x;
+			record.normal[1] = store.normals[tri].y;
+			record.normal[2] = store.normals[tri].z;
+			record.material = store.materials[tri];
+		}
+
+		void unpack(const SpillRecord &record, TriangleStore &out)
+		{
+			DIF::DIFBuilder::Triangle tri;
+			for (int i = 0; i < 3; i++)
+			{
+				tri.points[i].vertex = glm::vec3(record.points[i * 3], record.points[i * 3 + 1], record.points[i * 3 + 2]);
+				tri.points[i].uv = glm::vec2(record.uvs[i * 2], record.uvs[i * 2 + 1]);
+				tri.points[i].normal = glm::vec3(record.normal[0], record.normal[1], record.normal[2]);
+			}
+			out.add(tri, record.material);
+		}
+	}
+
+	std::shared_ptr<SpillFile> SpillFile::create(const std::string &dir)
+	{
+		std::shared_ptr<SpillFile> spill(new SpillFile());
+#ifdef _WIN32
+		std::wstring widePath;
+		if (dir.empty())
+		{
+			wchar_t temp[MAX_PATH + 1];
+			DWORD length = GetTempPathW(MAX_PATH + 1, temp);
+			if (length == 0 || length > MAX_PATH)
+				return NULL;
+			widePath.assign(temp, length);
+		}
+		else
+		{
+			int length = MultiByteToWideChar(CP_UTF8, 0, dir.c_str(), -1, NULL, 0);
+			std::wstring wideDir(length, L'\0');
+			MultiByteToWideChar(CP_UTF8, 0, dir.c_str(), -1, &wideDir[0], length);
+			widePath = wideDir.c_str();
+			widePath += L"\\";
+		}
+		std::string name = spillName();
+		widePath += std::wstring(name.begin(), name.end());
+
+		// Never flushed to disk unless memory runs short, and gone once the handle is closed
+		HANDLE file = CreateFileW(widePath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return NULL;
+		spill->mFile = file;
+#else
+		std::string path = dir;
+		if (path.empty())
+		{
+			const char *temp = getenv("TMPDIR");
+			path = temp != NULL && *temp != '\0' ? temp : "/tmp";
+		}
+		path += "/" + spillName();
+
+		// Unlinked right away, the data lives as long as the descriptor
+		int file = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (file < 0)
+			return NULL;
+		unlink(path.c_str());
+		spill->mFile = file;
+#endif
+		return spill;
+	}
+
+	SpillFile::~SpillFile()
+	{
+		unmap();
+#ifdef _WIN32
+		if (mFile != NULL)
+			CloseHandle((HANDLE)mFile);
+#else
+		if (mFile >= 0)
+			close(mFile);
+#endif
+	}
+
+	bool SpillFile::append(const TriangleStore &store, std::vector<U32> &ids)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if ((unsigned long long)mRecords + store.size() > 0xFFFFFFFFULL)
+			return false;
+
+		// The view does not grow with the file, map again on the next read
+		unmap();
+
+		std::vector<SpillRecord> batch;
+		batch.reserve(std::min(store.size(), WriteBatch));
+		size_t written = 0;
+		while (written < store.size())
+		{
+			batch.clear();
+			for (size_t tri = written; tri < store.size() && batch.size() < WriteBatch; tri++)
+			{
+				batch.emplace_back();
+				pack(store, tri, batch.back());
+			}
+
+			size_t bytes = batch.size() * sizeof(SpillRecord);
+			unsigned long long offset = (unsigned long long)(mRecords + written) * sizeof(SpillRecord);
+#ifdef _WIN32
+			OVERLAPPED at = OVERLAPPED();
+			at.Offset = (DWORD)offset;
+			at.OffsetHigh = (DWORD)(offset >> 32);
+			DWORD done = 0;
+			if (!WriteFile((HANDLE)mFile, batch.data(), (DWORD)bytes, &done, &at) || done != bytes)
+				return false;
+#else
+			const char *data = (const char *)batch.data();
+			size_t done = 0;
+			while (done < bytes)
+			{
+				ssize_t result = pwrite(mFile, data + done, bytes - done, (off_t)(offset + done));
+				if (result <= 0)
+					return false;
+				done += (size_t)result;
+			}
+#endif
+			written += batch.size();
+		}
+
+		ids.reserve(ids.size() + store.size());
+		for (size_t tri = 0; tri < store.size(); tri++)
+			ids.push_back((U32)(mRecords + tri));
+		mRecords += store.size();
+		return true;
+	}
+
+	bool SpillFile::read(const std::vector<U32> &ids, size_t begin, size_t end, TriangleStore &out)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (begin >= end)
+			return true;
+		if (mViewRecords != mRecords && !map())
+			return false;
+
+		out.reserve(out.size() + (end - begin), out.points.size() + (end - begin) * 3, out.uvs.size() + (end - begin) * 3);
+		for (size_t i = begin; i < end; i++)
+		{
+			if (ids[i] >= mViewRecords)
+				return false;
+			SpillRecord record;
+			memcpy(&record, mView + (size_t)ids[i] * sizeof(SpillRecord), sizeof(SpillRecord));
+			unpack(record, out);
+		}
+		return true;
+	}
+
+	bool SpillFile::map()
+	{
+		unmap();
+		if (mRecords == 0)
+			return true;
+
+		size_t bytes = mRecords * sizeof(SpillRecord);
+#ifdef _WIN32
+		HANDLE mapping = CreateFileMappingW((HANDLE)mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL)
+			return false;
+		void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, bytes);
+		if (view == NULL)
+		{
+			CloseHandle(mapping);
+			return false;
+		}
+		mMapping = mapping;
+#else
+		void *view = mmap(NULL, bytes, PROT_READ, MAP_SHARED, mFile, 0);
+		if (view == MAP_FAILED)
+			return false;
+#endif
+		mView = (const char *)view;
+		mViewRecords = mRecords;
+		return true;
+	}
+
+	void SpillFile::unmap()
+	{
+		if (mView == NULL)
+			return;
+#ifdef _WIN32
+		UnmapViewOfFile(mView);
+		CloseHandle((HANDLE)mMapping);
+		mMapping = NULL;
+#else
+		munmap((void *)mView, mViewRecords * sizeof(SpillRecord));
+#endif
+		mView = NULL;
+		mViewRecords = 0;
+	}
+}
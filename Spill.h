@@ -0,0 +1,45 @@
+#pragma once
+#include "Triangles.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace DifBuilderLib
+{
+	// Triangles moved out of memory into a temporary file, one fixed size record each, and mapped back in to read.
+	// The file is deleted when the last builder referring to it lets go. Safe to read from several threads.
+	class SpillFile
+	{
+	public:
+		// dir is UTF-8, empty uses the system temporary directory. Returns NULL if the file cannot be created.
+		static std::shared_ptr<SpillFile> create(const std::string &dir);
+
+		~SpillFile();
+
+		// Appends every triangle of store and their record ids to ids. False on a write error, ids is then unchanged.
+		bool append(const TriangleStore &store, std::vector<U32> &ids);
+
+		// Appends the records ids[begin, end) to out
+		bool read(const std::vector<U32> &ids, size_t begin, size_t end, TriangleStore &out);
+
+	private:
+		SpillFile() = default;
+		SpillFile(const SpillFile &) = delete;
+		SpillFile &operator=(const SpillFile &) = delete;
+
+		bool map();
+		void unmap();
+
+		std::mutex mMutex;
+		size_t mRecords = 0;
+		const char *mView = NULL;
+		size_t mViewRecords = 0;
+#ifdef _WIN32
+		void *mFile = NULL;
+		void *mMapping = NULL;
+#else
+		int mFile = -1;
+#endif
+	};
+}
@@ -0,0 +1,107 @@
+#include "Stats.h"
+#include <cstdlib>
+#include <new>
+
+#ifdef DIFBUILDERLIB_TRACK_ALLOCATIONS
+#ifdef _WIN32
+#include <malloc.h>
+#define DIFBUILDERLIB_USABLE_SIZE(ptr) _msize(ptr)
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#define DIFBUILDERLIB_USABLE_SIZE(ptr) malloc_size(ptr)
+#else
+#include <malloc.h>
+#define DIFBUILDERLIB_USABLE_SIZE(ptr) malloc_usable_size(ptr)
+#endif
+#endif
+
+namespace DifBuilderLib
+{
+	namespace
+	{
+		thread_local AllocationScope *currentScope = NULL;
+	}
+
+	void trackAllocation(long long size)
+	{
+		for (AllocationScope *scope = currentScope; scope != NULL; scope = scope->mParent)
+		{
+			scope->mCurrent += size;
+			if (scope->mCurrent > scope->mPeak)
+				scope->mPeak = scope->mCurrent;
+		}
+	}
+
+	AllocationScope::AllocationScope() : mParent(currentScope), mCurrent(0), mPeak(0)
+	{
+		currentScope = this;
+	}
+
+	AllocationScope::~AllocationScope()
+	{
+		currentScope = mParent;
+	}
+
+	unsigned long long AllocationScope::peak() const
+	{
+		return (unsigned long long)mPeak;
+	}
+}
+
+#ifdef DIFBUILDERLIB_TRACK_ALLOCATIONS
+// Replaces the global allocator with malloc plus accounting. Sizes come from the heap itself, so memory
+// allocated before or outside a scope is freed correctly and only skews the counters of the scope freeing it.
+void *operator new(std::size_t size)
+{
+	void *ptr = malloc(size == 0 ? 1 : size);
+	if (ptr == NULL)
+		throw std::bad_alloc();
+	DifBuilderLib::trackAllocation((long long)DIFBUILDERLIB_USABLE_SIZE(ptr));
+	return ptr;
+}
+
+void *operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+	try
+	{
+		return operator new(size);
+	}
+	catch (...)
+	{
+		return NULL;
+	}
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+	return operator new(size, std::nothrow);
+}
+
+void operator delete(void *ptr) noexcept
+{
+	if (ptr == NULL)
+		return;
+	DifBuilderLib::trackAllocation(-(long long)DIFBUILDERLIB_USABLE_SIZE(ptr));
+	free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	operator delete(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+	operator delete(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+	operator delete(ptr);
+}
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+
+namespace DifBuilderLib
+{
+	// Filled in by a builder as it goes, read through get_build_stats. Plain C layout for ctypes.
+	struct BuildStats
+	{
+		// Wall time per phase in seconds
+		double submitSeconds;	 // add_triangle(s) calls
+		double partitionSeconds; // splitting this builder into chunks
+		double handoffSeconds;	 // feeding stored triangles to DIFBuilder
+		double buildSeconds;	 // DIFBuilder::build: BSP, hulls, texgens and the rest of the interior
+		double weldSeconds;
+		double cacheSeconds; // cache lookup and store
+
+		// Largest amount of memory held by allocations made during build, 0 unless built with DIFBUILDERLIB_TRACK_ALLOCATIONS
+		unsigned long long peakAllocatedBytes;
+
+		int triangles;
+		int materials;
+		int points;
+		int normals;
+		int planes;
+		int texGens;
+		int surfaces;
+		int windings;
+		int bspNodes;
+		int convexHulls;
+		int cacheHit;
+
+		// Distinct plane, side, material and texgen combinations among the surfaces, no surface merge goes below this
+		int surfaceGroups;
+
+		double layoutSeconds;
+		double mergeSeconds; // coplanar surface merging, when turned on
+	};
+
+	enum BuildPhase
+	{
+		BUILD_PHASE_HANDOFF = 0,
+		BUILD_PHASE_BUILD = 1,
+		BUILD_PHASE_WELD = 2,
+		BUILD_PHASE_CACHE = 3,
+		BUILD_PHASE_DONE = 4
+	};
+
+	// Called on the thread doing the build with progress in [0, 1] within phase, returns nonzero to cancel.
+	// DIFBuilder::build can't be interrupted, so a cancel takes effect between phases.
+	typedef int (*ProgressCallback)(void *user, int phase, float progress);
+
+	class Stopwatch
+	{
+	public:
+		Stopwatch() : mStart(std::chrono::steady_clock::now()) {}
+
+		double seconds() const
+		{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - mStart).count();
+		}
+
+	private:
+		std::chrono::steady_clock::time_point mStart;
+	};
+
+	// Tracks the peak of memory allocated on this thread while alive
+	class AllocationScope
+	{
+	public:
+		AllocationScope();
+		~AllocationScope();
+
+		unsigned long long peak() const;
+
+	private:
+		AllocationScope *mParent;
+		long long mCurrent;
+		long long mPeak;
+
+		friend void trackAllocation(long long size);
+	};
+
+	// Accounts size bytes, negative when freed, to every scope active on this thread
+	void trackAllocation(long long size);
+}
@@ -0,0 +1,245 @@
+#include "Surfaces.h"
+#include "Remap.h"
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace DifBuilderLib
+{
+	namespace
+	{
+		const U32 Unused = 0xFFFFFFFF;
+
+		// The engine builds collision fans of at most this many points, and fanMask has a bit per point
+		const size_t MaxWindingPoints = 32;
+
+		// Sine of the smallest turn a merged polygon may take at a corner, straighter corners are not merged
+		const float ConvexTolerance = 1e-4f;
+
+		// Strip position of every polygon corner, walked the way Interior::collisionFanFromSurface does
+		void stripOrder(size_t count, std::vector<size_t> &order)
+		{
+			order.clear();
+			order.push_back(0);
+			for (size_t i = 1; i < count; i += 2)
+				order.push_back(i);
+			for (size_t i = (count - 1) & ~(size_t)1; i > 0; i -= 2)
+				order.push_back(i);
+		}
+
+		bool sameGroup(const DIF::Interior::Surface &a, const DIF::Interior::Surface &b)
+		{
+			return a.planeIndex == b.planeIndex && a.planeFlipped == b.planeFlipped && a.textureIndex == b.textureIndex && a.texGenIndex == b.texGenIndex && a.surfaceFlags == b.surfaceFlags;
+		}
+
+		uint64_t edgeKey(U32 from, U32 to)
+		{
+			return ((uint64_t)from << 32) | to;
+		}
+
+		struct Merger
+		{
+			const DIF::Interior &interior;
+			std::unordered_map<uint64_t, U32> edges;
+			std::vector<bool> used;
+
+			explicit Merger(const DIF::Interior &interior) : interior(interior), used(interior.surface.size(), false)
+			{
+				for (size_t i = 0; i < interior.surface.size(); i++)
+				{
+					if (!mergeable((U32)i))
+						continue;
+					for (int j = 0; j < 3; j++)
+						edges.emplace(edgeKey(corner((U32)i, j), corner((U32)i, (j + 1) % 3)), (U32)i);
+				}
+			}
+
+			bool isTriangle(U32 surface) const
+			{
+				const DIF::Interior::Surface &s = interior.surface[surface];
+				if (s.windingCount != 3 || (size_t)s.windingStart + 3 > interior.index.size())
+					return false;
+				for (int j = 0; j < 3; j++)
+				{
+					if (interior.index[s.windingStart + j] >= interior.point.size())
+						return false;
+				}
+				return corner(surface, 0) != corner(surface, 1) && corner(surface, 1) != corner(surface, 2) && corner(surface, 2) != corner(surface, 0);
+			}
+
+			// A merged surface would need its lightmap placed anew, surfaces with one are left alone
+			bool mergeable(U32 surface) const
+			{
+				return isTriangle(surface) && !hasLightMap(interior, surface);
+			}
+
+			U32 corner(U32 surface, int i) const
+			{
+				return interior.index[interior.surface[surface].windingStart + i];
+			}
+
+			bool convex(U32 prev, U32 at, U32 next, const glm::vec3 &normal) const
+			{
+				glm::vec3 in = interior.point[at] - interior.point[prev];
+				glm::vec3 out = interior.point[next] - interior.point[at];
+				return glm::dot(glm::cross(in, out), normal) > ConvexTolerance * glm::length(in) * glm::length(out);
+			}
+
+			// Grows the polygon of seed by neighbours across its edges for as long as it stays convex
+			void grow(U32 seed, std::vector<U32> &polygon, std::vector<U32> &members)
+			{
+				polygon.assign({corner(seed, 0), corner(seed, 1), corner(seed, 2)});
+				members.assign(1, seed);
+				used[seed] = true;
+
+				const glm::vec3 &a = interior.point[polygon[0]];
+				glm::vec3 normal = glm::cross(interior.point[polygon[1]] - a, interior.point[polygon[2]] - a);
+				float area = glm::length(normal);
+				if (area > 0.0f)
+					normal /= area;
+
+				for (bool grown = true; grown && polygon.size() < MaxWindingPoints;)
+				{
+					grown = false;
+					for (size_t i = 0; i < polygon.size() && polygon.size() < MaxWindingPoints; i++)
+					{
+						size_t n = polygon.size();
+						U32 from = polygon[i];
+						U32 to = polygon[(i + 1) % n];
+						auto found = edges.find(edgeKey(to, from));
+						if (found == edges.end() || used[found->second] || !sameGroup(interior.surface[seed], interior.surface[found->second]))
+							continue;
+
+						// The neighbour runs to, from, apex, so the apex goes between from and to
+						U32 neighbour = found->second;
+						U32 apex = Unused;
+						for (int j = 0; j < 3; j++)
+						{
+							if (corner(neighbour, j) == from)
+								apex = corner(neighbour, (j + 1) % 3);
+						}
+						if (apex == Unused || std::find(polygon.begin(), polygon.end(), apex) != polygon.end())
+							continue;
+
+						U32 beforeFrom = polygon[(i + n - 1) % n];
+						U32 afterTo = polygon[(i + 2) % n];
+						if (!convex(beforeFrom, from, apex, normal) || !convex(from, apex, to, normal) || !convex(apex, to, afterTo, normal))
+							continue;
+
+						polygon.insert(polygon.begin() + i + 1, apex);
+						members.push_back(neighbour);
+						used[neighbour] = true;
+						grown = true;
+					}
+				}
+			}
+		};
+
+		// Rewrites list[start, start + count) through remap onto the end of out, dropping repeats
+		template <typename T, typename S, typename C>
+		void remapRange(const std::vector<T> &list, S &start, C &count, const std::vector<U32> &remap, std::vector<U32> &seen, U32 stamp, std::vector<T> &out)
+		{
+			size_t first = out.size();
+			size_t end = std::min(list.size(), (size_t)start + count);
+			for (size_t i = start; i < end; i++)
+			{
+				U32 reference = list[i];
+				if ((reference & NullSurfaceFlag) == 0 && reference < remap.size())
+				{
+					reference = remap[reference];
+					if (seen[reference] == stamp)
+						continue;
+					seen[reference] = stamp;
+				}
+				out.push_back((T)reference);
+			}
+			start = (S)first;
+			count = (C)(out.size() - first);
+		}
+	}
+
+	void mergeSurfaces(DIF::Interior &interior)
+	{
+		if (interior.surface.empty())
+			return;
+
+		Merger merger(interior);
+		std::vector<U32> remap(interior.surface.size(), Unused);
+		std::vector<DIF::Interior::Surface> surfaces;
+		std::vector<U32> windings;
+		surfaces.reserve(interior.surface.size());
+		windings.reserve(interior.index.size());
+
+		std::vector<U32> polygon;
+		std::vector<U32> members;
+		std::vector<size_t> order;
+		for (U32 i = 0; i < (U32)interior.surface.size(); i++)
+		{
+			if (merger.used[i])
+				continue;
+
+			DIF::Interior::Surface surface = interior.surface[i];
+			U32 start = (U32)windings.size();
+			if (merger.mergeable(i))
+			{
+				merger.grow(i, polygon, members);
+				stripOrder(polygon.size(), order);
+				windings.resize(windings.size() + polygon.size());
+				for (size_t j = 0; j < polygon.size(); j++)
+					windings[start + order[j]] = polygon[j];
+				if (members.size() > 1)
+					surface.fanMask = polygon.size() == MaxWindingPoints ? 0xFFFFFFFF : (U32)((1u << polygon.size()) - 1);
+			}
+			else
+			{
+				members.assign(1, i);
+				size_t end = std::min(interior.index.size(), (size_t)surface.windingStart + surface.windingCount);
+				for (size_t j = surface.windingStart; j < end; j++)
+					windings.push_back(interior.index[j]);
+			}
+
+			surface.windingStart = start;
+			surface.windingCount = (U32)(windings.size() - start);
+			for (U32 member : members)
+				remap[member] = (U32)surfaces.size();
+			surfaces.push_back(surface);
+		}
+
+		if (surfaces.size() == interior.surface.size())
+			return;
+		appendOtherWindings(interior, windings);
+		remapSurfaceArrays(interior, remap, surfaces.size());
+		interior.surface.swap(surfaces);
+		interior.index.swap(windings);
+
+		std::vector<U32> seen(interior.surface.size(), Unused);
+		U32 stamp = 0;
+
+		std::vector<U32> leafSurfaces;
+		leafSurfaces.reserve(interior.solidLeafSurface.size());
+		for (DIF::Interior::BSPSolidLeaf &leaf : interior.bspSolidLeaf)
+			remapRange(interior.solidLeafSurface, leaf.surfaceIndex, leaf.surfaceCount, remap, seen, stamp++, leafSurfaces);
+		interior.solidLeafSurface.swap(leafSurfaces);
+
+		std::vector<U32> hullSurfaces;
+		hullSurfaces.reserve(interior.hullSurfaceIndex.size());
+		for (DIF::Interior::ConvexHull &hull : interior.convexHull)
+			remapRange(interior.hullSurfaceIndex, hull.surfaceStart, hull.surfaceCount, remap, seen, stamp++, hullSurfaces);
+		interior.hullSurfaceIndex.swap(hullSurfaces);
+
+		std::vector<U16> zoneSurfaces;
+		zoneSurfaces.reserve(interior.zoneSurface.size());
+		for (DIF::Interior::Zone &zone : interior.zone)
+			remapRange(interior.zoneSurface, zone.surfaceStart, zone.surfaceCount, remap, seen, stamp++, zoneSurfaces);
+		interior.zoneSurface.swap(zoneSurfaces);
+	}
+
+	void mergeSurfaces(DIF::DIF &dif)
+	{
+		for (DIF::Interior &interior : dif.interior)
+			mergeSurfaces(interior);
+		for (DIF::Interior &interior : dif.subObject)
+			mergeSurfaces(interior);
+	}
+}
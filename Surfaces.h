@@ -0,0 +1,15 @@
+#pragma once
+#include "DIFBuilder/DIFBuilder.hpp"
+
+namespace DifBuilderLib
+{
+	// Merges adjacent triangle surfaces sharing plane, side, material, texgen and flags into convex polygons of up to
+	// 32 points, written as the zig zag strips the engine renders and turns into collision fans. Solid leaf, hull and
+	// zone surface lists are rewritten without repeats, the lightmap index arrays follow the surfaces and the null
+	// surface and portal windings are carried over. Surfaces with a lightmap are left alone, a merged one would need
+	// its lightmap placed anew. Run after welding, which is what gives coplanar triangles their shared planes,
+	// points and texgens.
+	void mergeSurfaces(DIF::Interior &interior);
+
+	void mergeSurfaces(DIF::DIF &dif);
+}
@@ -0,0 +1,81 @@
+#include "TexGen.h"
+
+namespace DifBuilderLib
+{
+	namespace
+	{
+		// Structure of arrays input for the projection, one lane per surface
+		struct TexGenLanes
+		{
+			std::vector<float> nx, ny, nz;	 // surface normal
+			std::vector<float> pd;			 // dot(normal, a point on the surface)
+			std::vector<float> x, y, z, d; // one texgen axis
+
+			void resize(size_t count)
+			{
+				for (std::vector<float> *lane : {&nx, &ny, &nz, &pd, &x, &y, &z, &d})
+					lane->resize(count);
+			}
+		};
+
+		// Kept free of branches and aliasing so the compiler vectorizes it
+		void project(TexGenLanes &lanes)
+		{
+			size_t count = lanes.x.size();
+			const float *nx = lanes.nx.data(), *ny = lanes.ny.data(), *nz = lanes.nz.data(), *pd = lanes.pd.data();
+			float *x = lanes.x.data(), *y = lanes.y.data(), *z = lanes.z.data(), *d = lanes.d.data();
+			for (size_t i = 0; i < count; i++)
+			{
+				float k = x[i] * nx[i] + y[i] * ny[i] + z[i] * nz[i];
+				x[i] -= k * nx[i];
+				y[i] -= k * ny[i];
+				z[i] -= k * nz[i];
+				d[i] += k * pd[i];
+			}
+		}
+	}
+
+	std::vector<DIF::Interior::TexGenEq> canonicalTexGens(const DIF::Interior &interior)
+	{
+		size_t count = interior.surface.size();
+		TexGenLanes lanes;
+		lanes.resize(count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const DIF::Interior::Surface &surface = interior.surface[i];
+			glm::vec3 n = interior.normal[interior.plane[surface.planeIndex & 0x7FFF].normalIndex];
+			glm::vec3 p = surface.windingCount > 0 ? interior.point[interior.index[surface.windingStart]] : glm::vec3(0.0f);
+			lanes.nx[i] = n.x;
+			lanes.ny[i] = n.y;
+			lanes.nz[i] = n.z;
+			lanes.pd[i] = n.x * p.x + n.y * p.y + n.z * p.z;
+		}
+
+		std::vector<DIF::Interior::TexGenEq> texGens(count);
+		for (int axis = 0; axis < 2; axis++)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				const DIF::Interior::TexGenEq &texGen = interior.texGenEq[interior.surface[i].texGenIndex];
+				const DIF::PlaneF &plane = axis == 0 ? texGen.planeX : texGen.planeY;
+				lanes.x[i] = plane.x;
+				lanes.y[i] = plane.y;
+				lanes.z[i] = plane.z;
+				lanes.d[i] = plane.d;
+			}
+
+			project(lanes);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				DIF::PlaneF &plane = axis == 0 ? texGens[i].planeX : texGens[i].planeY;
+				plane.x = lanes.x[i];
+				plane.y = lanes.y[i];
+				plane.z = lanes.z[i];
+				plane.d = lanes.d[i];
+			}
+		}
+		return texGens;
+	}
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "DIFBuilder/DIFBuilder.hpp"
+#include <vector>
+
+namespace DifBuilderLib
+{
+	// One texgen per surface with the component along the surface normal projected out of planeX and
+	// planeY and folded into their d. The UVs on the surface stay the same, but triangles sharing a plane and
+	// a continuous mapping end up with equal texgens that welding can merge.
+	std::vector<DIF::Interior::TexGenEq> canonicalTexGens(const DIF::Interior &interior);
+}
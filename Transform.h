@@ -0,0 +1,52 @@
+#pragma once
+#include "DIFBuilder/DIFBuilder.hpp"
+#include <cstddef>
+
+namespace DifBuilderLib
+{
+	// 16 floats in row major order, the way numpy lays out Blender's Matrix
+	inline glm::mat4 matrixFromRows(const float *rows)
+	{
+		glm::mat4 m(1.0f);
+		for (int row = 0; row < 4; row++)
+		{
+			for (int col = 0; col < 4; col++)
+				m[col][row] = rows[row * 4 + col];
+		}
+		return m;
+	}
+
+	// out[i] = m * (in[i], 1). Works on the matrix entries as plain floats so the compiler vectorizes the loop.
+	inline void transformPoints(const glm::mat4 &m, const float *in, size_t count, glm::vec3 *out)
+	{
+		const float m00 = m[0][0], m01 = m[1][0], m02 = m[2][0], m03 = m[3][0];
+		const float m10 = m[0][1], m11 = m[1][1], m12 = m[2][1], m13 = m[3][1];
+		const float m20 = m[0][2], m21 = m[1][2], m22 = m[2][2], m23 = m[3][2];
+		for (size_t i = 0; i < count; i++)
+		{
+			float x = in[i * 3], y = in[i * 3 + 1], z = in[i * 3 + 2];
+			out[i] = glm::vec3(m00 * x + m01 * y + m02 * z + m03, m10 * x + m11 * y + m12 * z + m13, m20 * x + m21 * y + m22 * z + m23);
+		}
+	}
+
+	// Normals go through the inverse transpose of the upper 3x3 and are renormalized, so they stay perpendicular
+	// to their faces under non-uniform scale
+	inline void transformNormals(const glm::mat4 &m, const float *in, size_t count, glm::vec3 *out)
+	{
+		glm::mat3 linear(1.0f);
+		for (int col = 0; col < 3; col++)
+			linear[col] = glm::vec3(m[col][0], m[col][1], m[col][2]);
+		glm::mat3 n = glm::transpose(glm::inverse(linear));
+
+		const float n00 = n[0][0], n01 = n[1][0], n02 = n[2][0];
+		const float n10 = n[0][1], n11 = n[1][1], n12 = n[2][1];
+		const float n20 = n[0][2], n21 = n[1][2], n22 = n[2][2];
+		for (size_t i = 0; i < count; i++)
+		{
+			float x = in[i * 3], y = in[i * 3 + 1], z = in[i * 3 + 2];
+			glm::vec3 v(n00 * x + n01 * y + n02 * z, n10 * x + n11 * y + n12 * z, n20 * x + n21 * y + n22 * z);
+			float length = glm::length(v);
+			out[i] = length > 0.0f ? v / length : v;
+		}
+	}
+}
@@ -0,0 +1,109 @@
+#include "Triangles.h"
+
+namespace DifBuilderLib
+{
+	namespace
+	{
+		const U32 Unused = 0xFFFFFFFF;
+
+		template <typename T>
+		U32 copyShared(U32 index, const std::vector<T> &from, std::vector<T> &to, std::vector<U32> &remap)
+		{
+			if (remap[index] == Unused)
+			{
+				remap[index] = (U32)to.size();
+				to.push_back(from[index]);
+			}
+			return remap[index];
+		}
+
+		template <typename T>
+		void hashVector(Hasher &hasher, const std::vector<T> &values)
+		{
+			hasher.addValue(values.size());
+			hasher.add(values.data(), values.size() * sizeof(T));
+		}
+	}
+
+	void TriangleStore::reserve(size_t triangleCount, size_t pointCount, size_t uvCount)
+	{
+		points.reserve(pointCount);
+		uvs.reserve(uvCount);
+		pointIndices.reserve(triangleCount * 3);
+		uvIndices.reserve(triangleCount * 3);
+		normals.reserve(triangleCount);
+		materials.reserve(triangleCount);
+	}
+
+	void TriangleStore::clear()
+	{
+		points.clear();
+		uvs.clear();
+		pointIndices.clear();
+		uvIndices.clear();
+		normals.clear();
+		materials.clear();
+	}
+
+	void TriangleStore::release()
+	{
+		std::vector<glm::vec3>().swap(points);
+		std::vector<glm::vec2>().swap(uvs);
+		std::vector<U32>().swap(pointIndices);
+		std::vector<U32>().swap(uvIndices);
+		std::vector<glm::vec3>().swap(normals);
+		std::vector<int>().swap(materials);
+	}
+
+	void TriangleStore::add(const DIF::DIFBuilder::Triangle &tri, int material)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			pointIndices.push_back((U32)points.size());
+			uvIndices.push_back((U32)uvs.size());
+			points.push_back(tri.points[i].vertex);
+			uvs.push_back(tri.points[i].uv);
+		}
+		normals.push_back(tri.points[0].normal);
+		materials.push_back(material);
+	}
+
+	DIF::DIFBuilder::Triangle TriangleStore::triangle(size_t tri) const
+	{
+		DIF::DIFBuilder::Triangle result;
+		for (int i = 0; i < 3; i++)
+		{
+			result.points[i].vertex = points[pointIndices[tri * 3 + i]];
+			result.points[i].uv = uvs[uvIndices[tri * 3 + i]];
+			result.points[i].normal = normals[tri];
+		}
+		return result;
+	}
+
+	void TriangleStore::extract(const std::vector<int> &order, TriangleStore &out) const
+	{
+		std::vector<U32> pointRemap(points.size(), Unused);
+		std::vector<U32> uvRemap(uvs.size(), Unused);
+		out.reserve(out.size() + order.size(), out.points.size() + order.size(), out.uvs.size() + order.size());
+		for (int tri : order)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				out.pointIndices.push_back(copyShared(pointIndices[tri * 3 + i], points, out.points, pointRemap));
+				out.uvIndices.push_back(copyShared(uvIndices[tri * 3 + i], uvs, out.uvs, uvRemap));
+			}
+			out.normals.push_back(normals[tri]);
+			out.materials.push_back(materials[tri]);
+		}
+	}
+
+	void TriangleStore::hash(Hasher &hasher) const
+	{
+		hashVector(hasher, points);
+		hashVector(hasher, uvs);
+		hashVector(hasher, pointIndices);
+		hashVector(hasher, uvIndices);
+		hashVector(hasher, normals);
+		hashVector(hasher, materials);
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "DIFBuilder/DIFBuilder.hpp"
+#include "Hash.h"
+#include <vector>
+
+namespace DifBuilderLib
+{
+	// Submitted triangles in structure of arrays form. Points and UVs are shared, an indexed mesh stores each
+	// vertex and loop once and its triangles refer to them. A triangle soup gets three of each per triangle, so it
+	// takes about as much memory as a record per triangle would (100 bytes); only indexed input is compact.
+	// Corners are kept in the winding DIFBuilder expects.
+	struct TriangleStore
+	{
+		std::vector<glm::vec3> points;
+		std::vector<glm::vec2> uvs;
+
+		// 3 per triangle
+		std::vector<U32> pointIndices;
+		std::vector<U32> uvIndices;
+
+		// 1 per triangle
+		std::vector<glm::vec3> normals;
+		std::vector<int> materials;
+
+		size_t size() const
+		{
+			return materials.size();
+		}
+
+		bool empty() const
+		{
+			return materials.empty();
+		}
+
+		const glm::vec3 &point(size_t tri, int corner) const
+		{
+			return points[pointIndices[tri * 3 + corner]];
+		}
+
+		void reserve(size_t triangleCount, size_t pointCount, size_t uvCount);
+
+		// Keeps the capacity
+		void clear();
+
+		// Frees the storage
+		void release();
+
+		void add(const DIF::DIFBuilder::Triangle &tri, int material);
+
+		// Expanded into the record DIFBuilder takes
+		DIF::DIFBuilder::Triangle triangle(size_t tri) const;
+
+		// Copies the triangles listed in order into out along with only the points and UVs they use
+		void extract(const std::vector<int> &order, TriangleStore &out) const;
+
+		void hash(Hasher &hasher) const;
+	};
+}
@@ -0,0 +1,316 @@
+#include "Weld.h"
+#include "TexGen.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace DifBuilderLib
+{
+	namespace
+	{
+		// Plane references carry the flipped flag in the high bit
+		const U32 PlaneFlipFlag = 0x8000;
+
+		// Values within tolerance of each other land in the same or a neighbouring cell, exact mode keys on the bits
+		int64_t quantize(float value, float tolerance)
+		{
+			if (tolerance > 0.0f)
+				return (int64_t)std::floor(value / tolerance);
+
+			if (value == 0.0f)
+				value = 0.0f; // -0 and 0 are the same point
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			return bits;
+		}
+
+		struct CellKey
+		{
+			int64_t v[8];
+			bool operator==(const CellKey &other) const
+			{
+				return memcmp(v, other.v, sizeof(v)) == 0;
+			}
+		};
+
+		struct CellHash
+		{
+			size_t operator()(const CellKey &key) const
+			{
+				uint64_t h = 14695981039346656037ULL;
+				for (int i = 0; i < 8; i++)
+					h = (h ^ (uint64_t)key.v[i]) * 1099511628211ULL;
+				return (size_t)h;
+			}
+		};
+
+		typedef std::unordered_map<CellKey, U32, CellHash> CellMap;
+
+		// Welds vec3s within tolerance per axis, looking through the 27 cells around each value
+		std::vector<U32> weldVectors(std::vector<glm::vec3> &values, float tolerance)
+		{
+			std::vector<U32> remap(values.size());
+			if (tolerance < 0.0f)
+			{
+				for (size_t i = 0; i < values.size(); i++)
+					remap[i] = (U32)i;
+				return remap;
+			}
+
+			CellMap cells;
+			cells.reserve(values.size());
+			std::vector<glm::vec3> welded;
+			welded.reserve(values.size());
+			int reach = tolerance > 0.0f ? 1 : 0;
+
+			for (size_t i = 0; i < values.size(); i++)
+			{
+				const glm::vec3 &value = values[i];
+				CellKey key = CellKey();
+				key.v[0] = quantize(value.x, tolerance);
+				key.v[1] = quantize(value.y, tolerance);
+				key.v[2] = quantize(value.z, tolerance);
+
+				bool found = false;
+				for (int dx = -reach; dx <= reach && !found; dx++)
+				{
+					for (int dy = -reach; dy <= reach && !found; dy++)
+					{
+						for (int dz = -reach; dz <= reach && !found; dz++)
+						{
+							CellKey neighbour = key;
+							neighbour.v[0] += dx;
+							neighbour.v[1] += dy;
+							neighbour.v[2] += dz;
+							auto it = cells.find(neighbour);
+							if (it == cells.end())
+								continue;
+							const glm::vec3 &other = welded[it->second];
+							if (std::fabs(other.x - value.x) <= tolerance && std::fabs(other.y - value.y) <= tolerance && std::fabs(other.z - value.z) <= tolerance)
+							{
+								remap[i] = it->second;
+								found = true;
+							}
+						}
+					}
+				}
+
+				if (!found)
+				{
+					remap[i] = (U32)welded.size();
+					cells.emplace(key, remap[i]);
+					welded.push_back(value);
+				}
+			}
+
+			values.swap(welded);
+			return remap;
+		}
+
+		std::vector<U32> weldPlanes(std::vector<DIF::Interior::Plane> &planes, float tolerance)
+		{
+			std::vector<U32> remap(planes.size());
+			if (tolerance < 0.0f)
+			{
+				for (size_t i = 0; i < planes.size(); i++)
+					remap[i] = (U32)i;
+				return remap;
+			}
+
+			CellMap cells;
+			cells.reserve(planes.size());
+			std::vector<DIF::Interior::Plane> welded;
+			welded.reserve(planes.size());
+			int reach = tolerance > 0.0f ? 1 : 0;
+
+			for (size_t i = 0; i < planes.size(); i++)
+			{
+				const DIF::Interior::Plane &plane = planes[i];
+				CellKey key = CellKey();
+				key.v[0] = plane.normalIndex;
+				key.v[1] = quantize(plane.planeDistance, tolerance);
+
+				bool found = false;
+				for (int dd = -reach; dd <= reach && !found; dd++)
+				{
+					CellKey neighbour = key;
+					neighbour.v[1] += dd;
+					auto it = cells.find(neighbour);
+					if (it != cells.end() && std::fabs(welded[it->second].planeDistance - plane.planeDistance) <= tolerance)
+					{
+						remap[i] = it->second;
+						found = true;
+					}
+				}
+
+				if (!found)
+				{
+					remap[i] = (U32)welded.size();
+					cells.emplace(key, remap[i]);
+					welded.push_back(plane);
+				}
+			}
+
+			planes.swap(welded);
+			return remap;
+		}
+
+		// Texgens only merge within a cell, 3^8 neighbours would cost more than the few missed merges save
+		std::vector<U32> weldTexGens(std::vector<DIF::Interior::TexGenEq> &texGens, float tolerance)
+		{
+			std::vector<U32> remap(texGens.size());
+			if (tolerance < 0.0f)
+			{
+				for (size_t i = 0; i < texGens.size(); i++)
+					remap[i] = (U32)i;
+				return remap;
+			}
+
+			CellMap cells;
+			cells.reserve(texGens.size());
+			std::vector<DIF::Interior::TexGenEq> welded;
+			welded.reserve(texGens.size());
+
+			for (size_t i = 0; i < texGens.size(); i++)
+			{
+				const DIF::Interior::TexGenEq &texGen = texGens[i];
+				CellKey key;
+				key.v[0] = quantize(texGen.planeX.x, tolerance);
+				key.v[1] = quantize(texGen.planeX.y, tolerance);
+				key.v[2] = quantize(texGen.planeX.z, tolerance);
+				key.v[3] = quantize(texGen.planeX.d, tolerance);
+				key.v[4] = quantize(texGen.planeY.x, tolerance);
+				key.v[5] = quantize(texGen.planeY.y, tolerance);
+				key.v[6] = quantize(texGen.planeY.z, tolerance);
+				key.v[7] = quantize(texGen.planeY.d, tolerance);
+
+				auto it = cells.find(key);
+				if (it != cells.end())
+				{
+					remap[i] = it->second;
+					continue;
+				}
+
+				remap[i] = (U32)welded.size();
+				cells.emplace(key, remap[i]);
+				welded.push_back(texGen);
+			}
+
+			texGens.swap(welded);
+			return remap;
+		}
+
+		// Points every normal into the half space where its first nonzero component is positive so a plane and
+		// its opposite end up on the same normal. Returns which planes changed sign.
+		std::vector<bool> canonicalizeSigns(DIF::Interior &interior)
+		{
+			std::vector<bool> normalNegated(interior.normal.size(), false);
+			for (size_t i = 0; i < interior.normal.size(); i++)
+			{
+				glm::vec3 &normal = interior.normal[i];
+				float lead = normal.x != 0.0f ? normal.x : (normal.y != 0.0f ? normal.y : normal.z);
+				if (lead < 0.0f)
+				{
+					normal = -normal;
+					normalNegated[i] = true;
+				}
+			}
+
+			std::vector<bool> planeNegated(interior.plane.size(), false);
+			for (size_t i = 0; i < interior.plane.size(); i++)
+			{
+				DIF::Interior::Plane &plane = interior.plane[i];
+				if (normalNegated[plane.normalIndex])
+				{
+					plane.planeDistance = -plane.planeDistance;
+					planeNegated[i] = true;
+				}
+			}
+			return planeNegated;
+		}
+
+		template <typename T>
+		void remapPlaneReference(T &reference, const std::vector<U32> &remap, const std::vector<bool> &negated)
+		{
+			U32 index = reference & ~PlaneFlipFlag;
+			U32 flag = reference & PlaneFlipFlag;
+			if (negated[index])
+				flag ^= PlaneFlipFlag;
+			reference = (T)(remap[index] | flag);
+		}
+	}
+
+	void weldInterior(DIF::Interior &interior, const WeldTolerances &tolerances, bool mergeOpposite)
+	{
+		// Taken from the unwelded arrays, where every index is still consistent. The projection changes the
+		// texgen values by float rounding, so exact welding of texgens leaves the builder's alone
+		std::vector<DIF::Interior::TexGenEq> canonical;
+		if (tolerances.texGen > 0.0f && !interior.surface.empty())
+			canonical = canonicalTexGens(interior);
+
+		// Opposite faces, as double sided builds produce, share a plane and refer to it flipped
+		std::vector<bool> planeNegated(interior.plane.size(), false);
+		if (mergeOpposite && tolerances.normal >= 0.0f)
+			planeNegated = canonicalizeSigns(interior);
+
+		size_t pointCount = interior.point.size();
+		std::vector<U32> pointRemap = weldVectors(interior.point, tolerances.point);
+		std::vector<U32> normalRemap = weldVectors(interior.normal, tolerances.normal);
+
+		// Normals first so equal planes share a normal index to hash on
+		for (DIF::Interior::Plane &plane : interior.plane)
+			plane.normalIndex = (U16)normalRemap[plane.normalIndex];
+		std::vector<U32> planeRemap = weldPlanes(interior.plane, tolerances.planeDistance);
+		std::vector<U32> texGenRemap = weldTexGens(interior.texGenEq, tolerances.texGen);
+
+		// Per surface canonical texgens only win if they merge into fewer than the builder's own
+		std::vector<U32> canonicalRemap = weldTexGens(canonical, tolerances.texGen);
+		bool useCanonical = !canonical.empty() && canonical.size() < interior.texGenEq.size();
+		if (useCanonical)
+			interior.texGenEq.swap(canonical);
+
+		for (U32 &index : interior.index)
+			index = pointRemap[index];
+		for (U32 &index : interior.hullIndex)
+			index = pointRemap[index];
+		for (U32 &index : interior.polyListPointIndex)
+			index = pointRemap[index];
+
+		if (interior.pointVisibility.size() == pointCount)
+		{
+			std::vector<U8> visibility(interior.point.size(), 0);
+			for (size_t i = 0; i < pointCount; i++)
+				visibility[pointRemap[i]] |= interior.pointVisibility[i];
+			interior.pointVisibility.swap(visibility);
+		}
+
+		for (size_t i = 0; i < interior.surface.size(); i++)
+		{
+			DIF::Interior::Surface &surface = interior.surface[i];
+			if (planeNegated[surface.planeIndex])
+				surface.planeFlipped = !surface.planeFlipped;
+			surface.planeIndex = (U16)planeRemap[surface.planeIndex];
+			surface.texGenIndex = useCanonical ? canonicalRemap[i] : texGenRemap[surface.texGenIndex];
+		}
+		for (DIF::Interior::BSPNode &node : interior.bspNode)
+			remapPlaneReference(node.planeIndex, planeRemap, planeNegated);
+		for (U16 &index : interior.hullPlaneIndex)
+			remapPlaneReference(index, planeRemap, planeNegated);
+		for (U16 &index : interior.polyListPlaneIndex)
+			remapPlaneReference(index, planeRemap, planeNegated);
+		for (DIF::Interior::NullSurface &surface : interior.nullSurface)
+			remapPlaneReference(surface.planeIndex, planeRemap, planeNegated);
+		for (DIF::Interior::Portal &portal : interior.portal)
+			remapPlaneReference(portal.planeIndex, planeRemap, planeNegated);
+	}
+
+	void weldDif(DIF::DIF &dif, const WeldTolerances &tolerances, bool mergeOpposite)
+	{
+		for (DIF::Interior &interior : dif.interior)
+			weldInterior(interior, tolerances, mergeOpposite);
+		for (DIF::Interior &interior : dif.subObject)
+			weldInterior(interior, tolerances, mergeOpposite);
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "DIFBuilder/DIFBuilder.hpp"
+
+namespace DifBuilderLib
+{
+	// Per table tolerances for welding, 0 merges exact duplicates only and a negative value turns the table off.
+	// A positive texGen tolerance also compares texgens after projecting them onto their surface, where float
+	// noise from the builder's per triangle fit would otherwise keep identical mappings apart. The default one
+	// moves a UV by at most about 1e-6 per unit of distance from the origin.
+	struct WeldTolerances
+	{
+		float point = 0.0f;
+		float normal = 0.0f;
+		float planeDistance = 0.0f;
+		float texGen = 1e-6f;
+	};
+
+	// Merges duplicate points, normals, planes and texgens of a built interior through quantized hash tables
+	// and rewrites everything that refers to them. With mergeOpposite, and normals not off, normals are made
+	// sign canonical first so opposite planes merge into one plane referred to flipped, for double sided builds.
+	void weldInterior(DIF::Interior &interior, const WeldTolerances &tolerances, bool mergeOpposite = false);
+
+	void weldDif(DIF::DIF &dif, const WeldTolerances &tolerances, bool mergeOpposite = false);
+}
@@ -0,0 +1,125 @@
+#include "Writer.h"
+#include <cstdio>
+#include <ostream>
+#include <streambuf>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+namespace DifBuilderLib
+{
+	namespace
+	{
+		// streambuf appending straight into a std::vector, so DIF::write lands in one contiguous buffer
+		class VectorStreamBuf : public std::streambuf
+		{
+		public:
+			explicit VectorStreamBuf(std::vector<char> &data) : mData(data) {}
+
+		protected:
+			int_type overflow(int_type ch) override
+			{
+				if (ch != traits_type::eof())
+					mData.push_back((char)ch);
+				return ch;
+			}
+
+			std::streamsize xsputn(const char *s, std::streamsize count) override
+			{
+				mData.insert(mData.end(), s, s + count);
+				return count;
+			}
+
+		private:
+			std::vector<char> &mData;
+		};
+
+		// streambuf that only counts what is written to it
+		class CountingStreamBuf : public std::streambuf
+		{
+		public:
+			size_t count() const
+			{
+				return mCount;
+			}
+
+		protected:
+			int_type overflow(int_type ch) override
+			{
+				if (ch != traits_type::eof())
+					mCount++;
+				return ch;
+			}
+
+			std::streamsize xsputn(const char *s, std::streamsize count) override
+			{
+				mCount += (size_t)count;
+				return count;
+			}
+
+		private:
+			size_t mCount = 0;
+		};
+
+		DIF::Version writeVersion()
+		{
+			DIF::Version ver;
+			ver.dif.type = DIF::Version::DIFVersion::MBG;
+			return ver;
+		}
+
+		size_t estimateSize(const DIF::Interior &interior)
+		{
+			return interior.point.size() * DiskPointSize + interior.normal.size() * DiskNormalSize + interior.plane.size() * DiskPlaneSize + interior.texGenEq.size() * DiskTexGenSize + interior.index.size() * DiskWindingSize + interior.surface.size() * DiskSurfaceSize + interior.bspNode.size() * DiskBSPNodeSize + interior.convexHull.size() * DiskConvexHullSize + interior.hullIndex.size() * DiskHullIndexSize + interior.hullPlaneIndex.size() * DiskHullPlaneIndexSize;
+		}
+	}
+
+	bool serialize(const DIF::DIF &dif, std::vector<char> &out)
+	{
+		size_t estimate = 4096;
+		for (const DIF::Interior &interior : dif.interior)
+			estimate += estimateSize(interior);
+		for (const DIF::Interior &interior : dif.subObject)
+			estimate += estimateSize(interior);
+		out.reserve(out.size() + estimate);
+
+		VectorStreamBuf buf(out);
+		std::ostream stream(&buf);
+		return dif.write(stream, writeVersion()) && stream.good();
+	}
+
+	size_t serializedSize(const DIF::DIF &dif)
+	{
+		CountingStreamBuf buf;
+		std::ostream stream(&buf);
+		dif.write(stream, writeVersion());
+		return buf.count();
+	}
+
+	size_t serializedSize(const DIF::Interior &interior)
+	{
+		CountingStreamBuf buf;
+		std::ostream stream(&buf);
+		interior.write(stream, writeVersion());
+		return buf.count();
+	}
+
+	bool writeFile(const std::string &path, const std::vector<char> &data)
+	{
+#ifdef _WIN32
+		int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, NULL, 0);
+		std::wstring widePath(length, L'\0');
+		MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &widePath[0], length);
+		FILE *file = _wfopen(widePath.c_str(), L"wb");
+#else
+		FILE *file = fopen(path.c_str(), "wb");
+#endif
+		if (file == NULL)
+			return false;
+
+		bool ok = data.empty() || fwrite(data.data(), 1, data.size(), file) == data.size();
+		return fclose(file) == 0 && ok;
+	}
+}
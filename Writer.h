@@ -0,0 +1,29 @@
+#pragma once
+#include "DIFBuilder/DIFBuilder.hpp"
+#include <string>
+#include <vector>
+
+namespace DifBuilderLib
+{
+	// Approximate bytes on disk per element of the interior arrays, for size estimates
+	const size_t DiskPointSize = 12;
+	const size_t DiskNormalSize = 12;
+	const size_t DiskPlaneSize = 6;
+	const size_t DiskTexGenSize = 32;
+	const size_t DiskWindingSize = 4;
+	const size_t DiskSurfaceSize = 40;
+	const size_t DiskBSPNodeSize = 6;
+	const size_t DiskConvexHullSize = 64;
+	const size_t DiskHullIndexSize = 4;
+	const size_t DiskHullPlaneIndexSize = 2;
+
+	// Serializes dif as an MBG DIF into out, sized up front from the interior arrays
+	bool serialize(const DIF::DIF &dif, std::vector<char> &out);
+
+	// Exact number of bytes serialize would produce, without keeping them
+	size_t serializedSize(const DIF::DIF &dif);
+	size_t serializedSize(const DIF::Interior &interior);
+
+	// Writes data to a UTF-8 path in a single call
+	bool writeFile(const std::string &path, const std::vector<char> &data);
+}
@@ -200,10 +200,10 @@ class ExportDIF(bpy.types.Operator, ExportHelper):
 
     maxpolys = IntProperty(
         name="Polygons per DIF",
-        description="Maximum number of polygons till a dif split is done",
-        default=16000,
-        min=1,
-        max=16000,
+        description="Starting polygon budget per DIF, 0 derives it from the DIF format limits. DIFs that would still cross a limit are split further",
+        default=0,
+        min=0,
+        max=65535,
     )
 
     applymodifiers = BoolProperty(
@@ -224,24 +224,95 @@ class ExportDIF(bpy.types.Operator, ExportHelper):
         default=False,
     )
 
+    usecache = BoolProperty(
+        name="Reuse Unchanged Chunks",
+        description="Keep built chunks in a cache and reuse them when their geometry has not changed since the last export",
+        default=False,
+    )
+
+    streaming = BoolProperty(
+        name="Stream to Disk",
+        description="Keep exported triangles in a temporary file instead of memory, for scenes too large to fit",
+        default=False,
+    )
+
     check_extension = True
 
     def execute(self, context):
         from . import export_dif
 
         keywords = self.as_keywords(ignore=("check_existing", "filter_glob"))
-        export_dif.save(
-            context,
+        args = (
             keywords["filepath"],
             keywords.get("flip", False),
             keywords.get("double", False),
-            keywords.get("maxpolys", 16000),
+            keywords.get("maxpolys", 0),
             keywords.get("applymodifiers", True),
             keywords.get("exportvisible", True),
             keywords.get("exportselected", False),
+            keywords.get("usecache", False),
+            keywords.get("streaming", False),
         )
+
+        # Without a window, as in background mode, there is nothing to keep responsive
+        if context.window is None:
+            try:
+                stats = export_dif.save(context, *args)
+            finally:
+                context.window_manager.progress_end()
+            self.report_stats(stats)
+            return {"FINISHED"}
+
+        self._steps = export_dif.save_steps(context, *args)
+        self._timer = context.window_manager.event_timer_add(0.02, window=context.window)
+        context.window_manager.modal_handler_add(self)
+        return {"RUNNING_MODAL"}
+
+    def modal(self, context, event):
+        from . import export_dif
+
+        if event.type == "ESC":
+            self._steps.close()
+            self.stop(context)
+            self.report({"WARNING"}, "DIF export cancelled")
+            return {"CANCELLED"}
+
+        if event.type != "TIMER":
+            return {"PASS_THROUGH"}
+
+        try:
+            (finished, stats) = export_dif.advance(self._steps, 0.05)
+        except Exception as e:
+            self.stop(context)
+            self.report({"ERROR"}, "DIF export failed: %s" % e)
+            return {"CANCELLED"}
+
+        if not finished:
+            return {"RUNNING_MODAL"}
+
+        self.stop(context)
+        self.report_stats(stats)
         return {"FINISHED"}
 
+    def stop(self, context):
+        context.window_manager.event_timer_remove(self._timer)
+        context.window_manager.progress_end()
+        self._steps = None
+
+    def report_stats(self, stats):
+        if stats is not None:
+            self.report(
+                {"INFO"},
+                "Exported %d triangles: %d planes, %d BSP nodes, %d hulls, built in %.2fs"
+                % (
+                    stats["triangles"],
+                    stats["planes"],
+                    stats["bspNodes"],
+                    stats["convexHulls"],
+                    stats["buildSeconds"],
+                ),
+            )
+
 
 classes = (ExportDIF, ImportDIF)
 
@@ -3,6 +3,8 @@ from typing import Dict
 import bpy
 import ctypes
 import os
+import time
+import numpy as np
 from pathlib import Path
 
 from bpy.types import Curve, Image, Material, Mesh, Object, ShaderNodeTexImage
@@ -20,6 +22,8 @@ except:
 
 difbuilderlib.new_difbuilder.restype = ctypes.c_void_p
 difbuilderlib.dispose_difbuilder.argtypes = [ctypes.c_void_p]
+difbuilderlib.reserve_difbuilder.argtypes = [ctypes.c_void_p, ctypes.c_int]
+difbuilderlib.reset_difbuilder.argtypes = [ctypes.c_void_p]
 difbuilderlib.add_triangle.argtypes = [
     ctypes.c_void_p,
     ctypes.POINTER(ctypes.c_float),
@@ -31,11 +35,212 @@ difbuilderlib.add_triangle.argtypes = [
     ctypes.POINTER(ctypes.c_float),
     ctypes.c_char_p,
 ]
+difbuilderlib.register_material.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+difbuilderlib.register_material.restype = ctypes.c_int
+difbuilderlib.add_triangles.argtypes = [
+    ctypes.c_void_p,
+    ctypes.POINTER(ctypes.c_float),
+    ctypes.POINTER(ctypes.c_float),
+    ctypes.POINTER(ctypes.c_float),
+    ctypes.POINTER(ctypes.c_int),
+    ctypes.c_int,
+    ctypes.POINTER(ctypes.c_float),
+]
+difbuilderlib.add_indexed_mesh.argtypes = [
+    ctypes.c_void_p,
+    ctypes.POINTER(ctypes.c_float),
+    ctypes.c_int,
+    ctypes.POINTER(ctypes.c_float),
+    ctypes.POINTER(ctypes.c_int),
+    ctypes.c_int,
+    ctypes.POINTER(ctypes.c_int),
+    ctypes.POINTER(ctypes.c_int),
+    ctypes.c_int,
+    ctypes.POINTER(ctypes.c_float),
+]
+difbuilderlib.set_weld_tolerances.argtypes = [
+    ctypes.c_void_p,
+    ctypes.c_float,
+    ctypes.c_float,
+    ctypes.c_float,
+    ctypes.c_float,
+]
+difbuilderlib.set_optimize_layout.argtypes = [ctypes.c_void_p, ctypes.c_bool]
+difbuilderlib.set_merge_surfaces.argtypes = [ctypes.c_void_p, ctypes.c_bool]
+difbuilderlib.set_face_mode.argtypes = [ctypes.c_void_p, ctypes.c_int]
+difbuilderlib.set_build_cache.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+difbuilderlib.set_streaming.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int]
+difbuilderlib.get_bounds.argtypes = [
+    ctypes.c_void_p,
+    ctypes.POINTER(ctypes.c_float),
+    ctypes.POINTER(ctypes.c_float),
+]
+difbuilderlib.get_bounds.restype = ctypes.c_bool
+difbuilderlib.set_offset.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_float)]
+difbuilderlib.compute_shared_offset.argtypes = [
+    ctypes.POINTER(ctypes.c_void_p),
+    ctypes.c_int,
+    ctypes.POINTER(ctypes.c_float),
+    ctypes.POINTER(ctypes.c_float),
+    ctypes.POINTER(ctypes.c_float),
+]
+difbuilderlib.get_triangle_count.argtypes = [ctypes.c_void_p]
+difbuilderlib.get_triangle_count.restype = ctypes.c_int
+difbuilderlib.get_partition_count.argtypes = [ctypes.c_void_p, ctypes.c_int]
+difbuilderlib.get_partition_count.restype = ctypes.c_int
+difbuilderlib.partition_difbuilder.argtypes = [
+    ctypes.c_void_p,
+    ctypes.c_int,
+    ctypes.c_int,
+    ctypes.POINTER(ctypes.c_void_p),
+]
+
+# DifBuilderLib::PartitionStrategy
+PARTITION_MEDIAN = 0
+PARTITION_BINNED = 1
+
+
+# Face mode flags, mirrors DifBuilderLib::FaceFlags
+FACE_FLIP = 1
+FACE_DOUBLE_SIDED = 2
+
+# Triangles a streaming builder keeps in memory before moving them to its spill file
+STREAM_SPILL_TRIANGLES = 65536
+
+
+class BuildStats(ctypes.Structure):
+    """Mirrors DifBuilderLib::BuildStats"""
+
+    _fields_ = [
+        ("submitSeconds", ctypes.c_double),
+        ("partitionSeconds", ctypes.c_double),
+        ("handoffSeconds", ctypes.c_double),
+        ("buildSeconds", ctypes.c_double),
+        ("weldSeconds", ctypes.c_double),
+        ("cacheSeconds", ctypes.c_double),
+        ("peakAllocatedBytes", ctypes.c_ulonglong),
+        ("triangles", ctypes.c_int),
+        ("materials", ctypes.c_int),
+        ("points", ctypes.c_int),
+        ("normals", ctypes.c_int),
+        ("planes", ctypes.c_int),
+        ("texGens", ctypes.c_int),
+        ("surfaces", ctypes.c_int),
+        ("windings", ctypes.c_int),
+        ("bspNodes", ctypes.c_int),
+        ("convexHulls", ctypes.c_int),
+        ("cacheHit", ctypes.c_int),
+        ("surfaceGroups", ctypes.c_int),
+        ("layoutSeconds", ctypes.c_double),
+        ("mergeSeconds", ctypes.c_double),
+    ]
+
+    def as_dict(self):
+        return {name: getattr(self, name) for (name, _) in self._fields_}
+
+
+class AnalysisReport(ctypes.Structure):
+    """Mirrors DifBuilderLib::AnalysisReport"""
+
+    _fields_ = [
+        ("interiors", ctypes.c_int),
+        ("subObjects", ctypes.c_int),
+        ("totalBytes", ctypes.c_ulonglong),
+        ("interiorBytes", ctypes.c_ulonglong),
+        ("subObjectBytes", ctypes.c_ulonglong),
+        ("pointBytes", ctypes.c_ulonglong),
+        ("normalBytes", ctypes.c_ulonglong),
+        ("planeBytes", ctypes.c_ulonglong),
+        ("texGenBytes", ctypes.c_ulonglong),
+        ("windingBytes", ctypes.c_ulonglong),
+        ("surfaceBytes", ctypes.c_ulonglong),
+        ("bspBytes", ctypes.c_ulonglong),
+        ("hullBytes", ctypes.c_ulonglong),
+        ("polyListBytes", ctypes.c_ulonglong),
+        ("lightMapBytes", ctypes.c_ulonglong),
+        ("points", ctypes.c_int),
+        ("normals", ctypes.c_int),
+        ("planes", ctypes.c_int),
+        ("texGens", ctypes.c_int),
+        ("surfaces", ctypes.c_int),
+        ("windings", ctypes.c_int),
+        ("bspNodes", ctypes.c_int),
+        ("bspEmptyLeaves", ctypes.c_int),
+        ("bspSolidLeaves", ctypes.c_int),
+        ("convexHulls", ctypes.c_int),
+        ("bspMaxDepth", ctypes.c_int),
+        ("bspAverageLeafDepth", ctypes.c_double),
+        ("solidLeafSurfaceMax", ctypes.c_int),
+        ("solidLeafSurfaceAverage", ctypes.c_double),
+        ("hullPlaneAverage", ctypes.c_double),
+        ("hullPointAverage", ctypes.c_double),
+        ("surfacesPerPlane", ctypes.c_double),
+        ("surfacesPerTexGen", ctypes.c_double),
+        ("planeReferencesPerPlane", ctypes.c_double),
+        ("pointReferencesPerPoint", ctypes.c_double),
+        ("collisionHullsPerQuery", ctypes.c_double),
+        ("collisionPlaneTestsPerQuery", ctypes.c_double),
+    ]
+
+    def as_dict(self):
+        return {name: getattr(self, name) for (name, _) in self._fields_}
+
+
+# int callback(void *user, int phase, float progress), nonzero cancels
+PROGRESS_CALLBACK = ctypes.CFUNCTYPE(
+    ctypes.c_int, ctypes.c_void_p, ctypes.c_int, ctypes.c_float
+)
+difbuilderlib.set_progress_callback.argtypes = [
+    ctypes.c_void_p,
+    PROGRESS_CALLBACK,
+    ctypes.c_void_p,
+]
+difbuilderlib.get_build_stats.argtypes = [ctypes.c_void_p, ctypes.POINTER(BuildStats)]
 difbuilderlib.build.argtypes = [ctypes.c_void_p]
 difbuilderlib.build.restype = ctypes.c_void_p
+difbuilderlib.build_many.argtypes = [
+    ctypes.POINTER(ctypes.c_void_p),
+    ctypes.c_int,
+    ctypes.POINTER(ctypes.c_void_p),
+    ctypes.c_int,
+]
+difbuilderlib.get_limit_usage.argtypes = [ctypes.c_void_p]
+difbuilderlib.get_limit_usage.restype = ctypes.c_double
+difbuilderlib.get_split_budget.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
+difbuilderlib.get_split_budget.restype = ctypes.c_int
+difbuilderlib.get_start_budget.argtypes = []
+difbuilderlib.get_start_budget.restype = ctypes.c_int
+difbuilderlib.build_async.argtypes = [ctypes.c_void_p]
+difbuilderlib.build_async.restype = ctypes.c_void_p
+difbuilderlib.poll_build.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_float)]
+difbuilderlib.poll_build.restype = ctypes.c_bool
+difbuilderlib.cancel_build.argtypes = [ctypes.c_void_p]
+difbuilderlib.wait_build.argtypes = [ctypes.c_void_p]
+difbuilderlib.wait_build.restype = ctypes.c_void_p
+
+difbuilderlib.analyze_dif.argtypes = [ctypes.c_void_p, ctypes.POINTER(AnalysisReport)]
 
 difbuilderlib.dispose_dif.argtypes = [ctypes.c_void_p]
 difbuilderlib.write_dif.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+difbuilderlib.write_dif.restype = ctypes.c_bool
+difbuilderlib.append_interior.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
+difbuilderlib.write_multi_dif.argtypes = [
+    ctypes.POINTER(ctypes.c_void_p),
+    ctypes.c_int,
+    ctypes.c_char_p,
+]
+difbuilderlib.write_multi_dif.restype = ctypes.c_bool
+difbuilderlib.write_dif_to_buffer.argtypes = [ctypes.c_void_p]
+difbuilderlib.write_dif_to_buffer.restype = ctypes.c_void_p
+difbuilderlib.get_buffer_data.argtypes = [ctypes.c_void_p]
+difbuilderlib.get_buffer_data.restype = ctypes.c_void_p
+difbuilderlib.get_buffer_size.argtypes = [ctypes.c_void_p]
+difbuilderlib.get_buffer_size.restype = ctypes.c_int
+difbuilderlib.dispose_buffer.argtypes = [ctypes.c_void_p]
+difbuilderlib.write_dif_async.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+difbuilderlib.write_dif_async.restype = ctypes.c_void_p
+difbuilderlib.wait_write.argtypes = [ctypes.c_void_p]
+difbuilderlib.wait_write.restype = ctypes.c_bool
 
 difbuilderlib.add_pathed_interior.argtypes = [
     ctypes.c_void_p,
@@ -114,9 +319,36 @@ class Dif:
         difbuilderlib.dispose_dif(self.__ptr__)
 
     def write_dif(self, path):
-        difbuilderlib.write_dif(
-            self.__ptr__, ctypes.create_string_buffer(path.encode("ascii"))
-        )
+        if not difbuilderlib.write_dif(self.__ptr__, path.encode("utf-8")):
+            raise Exception("Could not write DIF file: " + path)
+
+    def append_interior(self, other):
+        """
+        Moves the interiors of other behind this one's. Torque treats them as detail
+        levels and uses one at a time, so split chunks still go in separate files.
+        """
+        difbuilderlib.append_interior(self.__ptr__, other.__ptr__)
+
+    def analyze(self):
+        """Structure, size and collision cost figures of the DIF as a dict, see AnalysisReport"""
+        report = AnalysisReport()
+        difbuilderlib.analyze_dif(self.__ptr__, ctypes.byref(report))
+        return report.as_dict()
+
+    def write_async(self, path):
+        """Starts writing on a native thread, the Dif must stay alive until the job is waited on."""
+        return DifWriteJob(self, path)
+
+    def to_bytes(self):
+        buf = difbuilderlib.write_dif_to_buffer(self.__ptr__)
+        if buf == None:
+            raise Exception("Could not serialize DIF")
+        try:
+            return ctypes.string_at(
+                difbuilderlib.get_buffer_data(buf), difbuilderlib.get_buffer_size(buf)
+            )
+        finally:
+            difbuilderlib.dispose_buffer(buf)
 
     def add_game_entity(self, gameClass, datablock, position, scale, properties: dict):
         vecarr = (ctypes.c_float * len(position))(*position)
@@ -135,9 +367,58 @@ class Dif:
         )
 
 
+class DifWriteJob:
+    def __init__(self, dif: Dif, path):
+        self.dif = dif
+        self.path = path
+        self.__ptr__ = difbuilderlib.write_dif_async(dif.__ptr__, path.encode("utf-8"))
+
+    def wait(self):
+        ok = difbuilderlib.wait_write(self.__ptr__)
+        self.dif = None
+        if not ok:
+            raise Exception("Could not write DIF file: " + self.path)
+
+
+class DifBuildJob:
+    """A build on the native worker pool, the builder must not be used until the job is waited on."""
+
+    def __init__(self, builder):
+        self.builder = builder
+        self.__ptr__ = difbuilderlib.build_async(builder.__ptr__)
+
+    def poll(self):
+        """(done, rough progress in [0, 1]), never blocks"""
+        progress = ctypes.c_float()
+        done = difbuilderlib.poll_build(self.__ptr__, ctypes.byref(progress))
+        return (done, progress.value)
+
+    def cancel(self):
+        """Stops the build at its next phase boundary, wait then raises"""
+        difbuilderlib.cancel_build(self.__ptr__)
+
+    def wait(self):
+        ptr = difbuilderlib.wait_build(self.__ptr__)
+        self.__ptr__ = None
+        self.builder = None
+        if ptr == None:
+            raise Exception("DIF build failed or was cancelled")
+        return Dif(ptr)
+
+
+def matrix_pointer(matrix):
+    """16 row major floats of a 4x4 matrix for the native side, None stays None"""
+    if matrix is None:
+        return None
+    rows = np.ascontiguousarray(np.array(matrix, dtype=np.float32).reshape(16))
+    return rows.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
+
+
 class DifBuilder:
-    def __init__(self):
-        self.__ptr__ = difbuilderlib.new_difbuilder()
+    def __init__(self, ptr=None):
+        self.__ptr__ = ptr if ptr != None else difbuilderlib.new_difbuilder()
+        self.material_ids = {}
+        self.progress_callback = None
 
     def __del__(self):
         difbuilderlib.dispose_difbuilder(self.__ptr__)
@@ -159,6 +440,90 @@ class DifBuilder:
             self.__ptr__, p3arr, p2arr, p1arr, uv3arr, uv2arr, uv1arr, narr, mat
         )
 
+    def reserve(self, triangle_count):
+        difbuilderlib.reserve_difbuilder(self.__ptr__, triangle_count)
+
+    def reset(self):
+        """Clears the builder for reuse, keeping its allocated storage."""
+        difbuilderlib.reset_difbuilder(self.__ptr__)
+        self.material_ids = {}
+
+    def register_material(self, material):
+        if material not in self.material_ids:
+            self.material_ids[material] = difbuilderlib.register_material(
+                self.__ptr__, material.encode("ascii")
+            )
+        return self.material_ids[material]
+
+    def add_triangles(
+        self, positions, uvs, normals, material_indices, materials, matrix=None
+    ):
+        """
+        Submits a batch of triangles in one call. positions (9 floats per triangle),
+        uvs (6 floats), normals (3 floats) and material_indices (1 int indexing
+        materials) can be any contiguous float32/int32 buffer, such as the arrays
+        filled by foreach_get. matrix is an optional 4x4 world matrix applied natively.
+        """
+        positions = np.ascontiguousarray(positions, dtype=np.float32)
+        uvs = np.ascontiguousarray(uvs, dtype=np.float32)
+        normals = np.ascontiguousarray(normals, dtype=np.float32)
+
+        material_ids = np.array(
+            [self.register_material(m) for m in materials], dtype=np.int32
+        )
+        material_ids = np.ascontiguousarray(material_ids[material_indices])
+
+        difbuilderlib.add_triangles(
+            self.__ptr__,
+            positions.ctypes.data_as(ctypes.POINTER(ctypes.c_float)),
+            uvs.ctypes.data_as(ctypes.POINTER(ctypes.c_float)),
+            normals.ctypes.data_as(ctypes.POINTER(ctypes.c_float)),
+            material_ids.ctypes.data_as(ctypes.POINTER(ctypes.c_int)),
+            len(material_ids),
+            matrix_pointer(matrix),
+        )
+
+    def add_indexed_mesh(
+        self,
+        positions,
+        uvs,
+        loop_vertices,
+        loop_totals,
+        material_indices,
+        materials,
+        matrix=None,
+    ):
+        """
+        Submits a mesh in Blender's layout: positions (3 floats per vertex), uvs
+        (2 floats per loop, or None), loop_vertices (1 int per loop), and per polygon
+        loop_totals and material_indices (indexing materials). Polygons use
+        consecutive loops and are fan triangulated, triangles get their face normal.
+        matrix is an optional 4x4 world matrix applied to positions natively.
+        """
+        positions = np.ascontiguousarray(positions, dtype=np.float32)
+        loop_vertices = np.ascontiguousarray(loop_vertices, dtype=np.int32)
+        loop_totals = np.ascontiguousarray(loop_totals, dtype=np.int32)
+        if uvs is not None:
+            uvs = np.ascontiguousarray(uvs, dtype=np.float32)
+
+        material_ids = np.array(
+            [self.register_material(m) for m in materials], dtype=np.int32
+        )
+        material_ids = np.ascontiguousarray(material_ids[material_indices])
+
+        difbuilderlib.add_indexed_mesh(
+            self.__ptr__,
+            positions.ctypes.data_as(ctypes.POINTER(ctypes.c_float)),
+            positions.size // 3,
+            uvs.ctypes.data_as(ctypes.POINTER(ctypes.c_float)) if uvs is not None else None,
+            loop_vertices.ctypes.data_as(ctypes.POINTER(ctypes.c_int)),
+            loop_vertices.size,
+            loop_totals.ctypes.data_as(ctypes.POINTER(ctypes.c_int)),
+            material_ids.ctypes.data_as(ctypes.POINTER(ctypes.c_int)),
+            loop_totals.size,
+            matrix_pointer(matrix),
+        )
+
     def add_pathed_interior(self, dif: Dif, markerlist: MarkerList):
         difbuilderlib.add_pathed_interior(self.__ptr__, dif.__ptr__, markerlist.__ptr__)
 
@@ -174,8 +539,172 @@ class DifBuilder:
             props.__ptr__,
         )
 
+    def set_optimize_layout(self, enabled):
+        """
+        Reorders surfaces, windings and points of the built interior for locality.
+        Partitioned builders inherit the setting.
+        """
+        difbuilderlib.set_optimize_layout(self.__ptr__, enabled)
+
+    def set_merge_surfaces(self, enabled):
+        """
+        Merges adjacent coplanar triangles sharing a material and texgen into one
+        convex surface each. Partitioned builders inherit the setting.
+        """
+        difbuilderlib.set_merge_surfaces(self.__ptr__, enabled)
+
+    def set_face_mode(self, flip=False, double=False):
+        """
+        Flips and/or doubles every triangle when building, without submitting them again.
+        Doubled faces still reach DIFBuilder as triangles of their own, only their planes
+        are shared, by welding the built interior. Partitioned builders inherit the mode.
+        """
+        flags = (FACE_FLIP if flip else 0) | (FACE_DOUBLE_SIDED if double else 0)
+        difbuilderlib.set_face_mode(self.__ptr__, flags)
+
+    def set_build_cache(self, cache_dir):
+        """
+        Reuses the DIF built from identical inputs from cache_dir instead of building it again,
+        and stores newly built ones there. None disables the cache. Partitioned builders inherit it.
+        Entries unused for 30 days go, then the least recently used ones beyond 1 GiB.
+        """
+        difbuilderlib.set_build_cache(
+            self.__ptr__, cache_dir.encode("utf-8") if cache_dir is not None else None
+        )
+
+    def set_streaming(self, spill_dir=None, spill_triangles=STREAM_SPILL_TRIANGLES):
+        """
+        Moves submitted triangles to a temporary file in spill_dir (None for the system
+        temporary directory) every spill_triangles triangles, chunks are read back only
+        while they are handed to DifBuilder. 0 turns it off. Partitioned builders inherit it.
+        """
+        difbuilderlib.set_streaming(
+            self.__ptr__,
+            spill_dir.encode("utf-8") if spill_dir is not None else None,
+            spill_triangles,
+        )
+
+    def set_weld_tolerances(self, point=0, normal=0, plane_distance=0, texgen=1e-6):
+        """
+        Sets how close points, normals, plane distances and texgens must be to get merged after building.
+        0 merges exact duplicates only, a negative tolerance disables welding for that table.
+        With a positive texgen tolerance, the default 1e-6, texgens are projected onto their surface
+        first so continuous mappings on one plane merge. 0 keeps the builder's texgens as they are.
+        Partitioned builders inherit the tolerances.
+        """
+        difbuilderlib.set_weld_tolerances(
+            self.__ptr__, point, normal, plane_distance, texgen
+        )
+
+    def bounds(self):
+        """(min, max) of the submitted vertices before offset, None if there are none"""
+        minv = (ctypes.c_float * 3)()
+        maxv = (ctypes.c_float * 3)()
+        if not difbuilderlib.get_bounds(self.__ptr__, minv, maxv):
+            return None
+        return (tuple(minv), tuple(maxv))
+
+    def set_offset(self, offset):
+        """Added to every vertex at build time, partitioned builders inherit it"""
+        difbuilderlib.set_offset(self.__ptr__, (ctypes.c_float * 3)(*offset))
+
+    def triangle_count(self):
+        return difbuilderlib.get_triangle_count(self.__ptr__)
+
+    def partition(self, maxtricount, strategy=PARTITION_BINNED):
+        """
+        Splits the submitted triangles into spatially compact DifBuilders of at most
+        maxtricount triangles each. Pathed interiors and triggers are added to the first one too.
+        """
+        count = difbuilderlib.get_partition_count(self.__ptr__, maxtricount)
+        builderarr = (ctypes.c_void_p * count)()
+        difbuilderlib.partition_difbuilder(
+            self.__ptr__, maxtricount, strategy, builderarr
+        )
+        return [DifBuilder(ptr) for ptr in builderarr]
+
+    def split_budget(self, dif: Dif):
+        """
+        The maxtricount to partition this builder with when dif, built from it,
+        crosses a DIF format limit, 0 if it fits.
+        """
+        return difbuilderlib.get_split_budget(self.__ptr__, dif.__ptr__)
+
+    def set_progress(self, callback):
+        """
+        callback(phase, progress) is called during build, return True from it to cancel.
+        It runs on the building thread, which is a worker thread under build_many, so it must not touch bpy.
+        Partitioned builders inherit it, keep this builder alive while they build.
+        """
+        if callback is None:
+            self.progress_callback = None
+            difbuilderlib.set_progress_callback(
+                self.__ptr__, ctypes.cast(None, PROGRESS_CALLBACK), None
+            )
+            return
+
+        self.progress_callback = PROGRESS_CALLBACK(
+            lambda user, phase, progress: 1 if callback(phase, progress) else 0
+        )
+        difbuilderlib.set_progress_callback(self.__ptr__, self.progress_callback, None)
+
+    def stats(self):
+        """Timings and counters of the last submission, partition and build as a dict"""
+        stats = BuildStats()
+        difbuilderlib.get_build_stats(self.__ptr__, ctypes.byref(stats))
+        return stats.as_dict()
+
     def build(self):
-        return Dif(difbuilderlib.build(self.__ptr__))
+        ptr = difbuilderlib.build(self.__ptr__)
+        if ptr == None:
+            raise Exception("DIF build was cancelled")
+        return Dif(ptr)
+
+    def build_async(self):
+        """Starts the build on the native worker pool and returns a DifBuildJob"""
+        return DifBuildJob(self)
+
+
+def write_multi_dif(difs, path):
+    """Writes the first Dif with the interiors of the others as its lower detail levels"""
+    ptrs = (ctypes.c_void_p * len(difs))(*[dif.__ptr__ for dif in difs])
+    if not difbuilderlib.write_multi_dif(ptrs, len(difs), path.encode("utf-8")):
+        raise Exception("Could not write DIF file: " + path)
+
+
+def compute_shared_offset(builders, extra_bounds=[]):
+    """
+    Offset that gives every builder one common origin, extra_bounds is a list of
+    (min, max) for geometry that is not part of any of the builders.
+    """
+    count = len(builders)
+    builderarr = (ctypes.c_void_p * max(count, 1))(*[b.__ptr__ for b in builders])
+    extra_min = extra_max = None
+    if len(extra_bounds) != 0:
+        extra_min = (ctypes.c_float * 3)(*np.min([b[0] for b in extra_bounds], axis=0))
+        extra_max = (ctypes.c_float * 3)(*np.max([b[1] for b in extra_bounds], axis=0))
+    out = (ctypes.c_float * 3)()
+    difbuilderlib.compute_shared_offset(builderarr, count, extra_min, extra_max, out)
+    return tuple(out)
+
+
+def build_many(builders, threads=0):
+    """
+    Builds every DifBuilder in parallel on the native worker pool. ctypes drops
+    the GIL for the duration of the call.
+    """
+    count = len(builders)
+    if count == 0:
+        return []
+
+    builderarr = (ctypes.c_void_p * count)(*[b.__ptr__ for b in builders])
+    difarr = (ctypes.c_void_p * count)()
+    difbuilderlib.build_many(builderarr, count, difarr, threads)
+
+    difs = [Dif(ptr) if ptr != None else None for ptr in difarr]
+    if None in difs:
+        raise Exception("Failed to build one or more DIFs")
+    return difs
 
 
 def mesh_triangulate(me):
@@ -189,7 +718,13 @@ def mesh_triangulate(me):
 
 
 def resolve_texture(mat: Material):
+    if mat == None:
+        return "NULL"
+
     img: ShaderNodeTexImage = None
+    if mat.node_tree == None:
+        return mat.name
+
     for n in mat.node_tree.nodes:
         if n.type == "TEX_IMAGE":
             img = n
@@ -201,78 +736,80 @@ def resolve_texture(mat: Material):
     return Path(img.image.filepath).stem
 
 
-def get_offset(depsgraph, applymodifiers=True):
-    obs = bpy.context.scene.objects
-    minv = [1e9, 1e9, 1e9]
-    maxv = [-1e9, -1e9, -1e9]
+def object_materials(ob: Object):
+    """Texture names of the object's slots, slot.material follows slots linked to the object as well as the mesh"""
+    return [resolve_texture(slot.material) for slot in ob.material_slots]
 
-    for obj in obs:
-        ob_eval = obj.evaluated_get(depsgraph) if applymodifiers else obj
-        try:
-            mesh = ob_eval.to_mesh()
-        except RuntimeError:
-            continue
 
-        mesh.transform(ob_eval.matrix_world)
+def mesh_indexed_buffers(mesh: Mesh, ob: Object = None):
+    """
+    Gathers the vertices, loops and polygons of a mesh into the buffers taken by
+    DifBuilder.add_indexed_mesh. The loops of every polygon must be consecutive,
+    as they are in any mesh Blender builds.
+    Materials come from the slots of ob when given, from the mesh otherwise.
+    Flipping and doubling is left to DifBuilder.set_face_mode.
+    """
+    vert_count = len(mesh.vertices)
+    poly_count = len(mesh.polygons)
+    loop_count = len(mesh.loops)
 
-        for vert in mesh.vertices:
-            for i in range(0, 3):
-                if minv[i] > vert.co[i]:
-                    minv[i] = vert.co[i]
-                if maxv[i] < vert.co[i]:
-                    maxv[i] = vert.co[i]
+    co = np.empty(vert_count * 3, dtype=np.float32)
+    mesh.vertices.foreach_get("co", co)
 
-    off = [((maxv[i] - minv[i]) / 2) + 50 for i in range(0, 3)]
-    return off
+    loop_verts = np.empty(loop_count, dtype=np.int32)
+    mesh.loops.foreach_get("vertex_index", loop_verts)
 
+    loop_uvs = None
+    if mesh.uv_layers.active != None:
+        loop_uvs = np.empty(loop_count * 2, dtype=np.float32)
+        mesh.uv_layers.active.data.foreach_get("uv", loop_uvs)
 
-def build_pathed_interior(ob: Object, marker_ob: Curve, offset, flip, double):
-    difbuilder = DifBuilder()
-    mesh = ob.to_mesh()
-    mesh_triangulate(mesh)
+    loop_totals = np.empty(poly_count, dtype=np.int32)
+    mesh.polygons.foreach_get("loop_total", loop_totals)
 
-    mesh_verts = mesh.vertices
+    poly_materials = np.empty(poly_count, dtype=np.int32)
+    mesh.polygons.foreach_get("material_index", poly_materials)
 
-    active_uv_layer = mesh.uv_layers.active.data
+    # Resolved once per mesh, the last entry catches empty or missing slots
+    if ob != None:
+        materials = object_materials(ob) + ["NULL"]
+    else:
+        materials = [resolve_texture(mat) for mat in mesh.materials] + ["NULL"]
+    poly_materials = np.minimum(poly_materials, len(materials) - 1)
 
-    for poly in mesh.polygons:
+    return (co, loop_uvs, loop_verts, loop_totals, poly_materials, materials)
 
-        rawp1 = mesh_verts[poly.vertices[0]].co
-        rawp2 = mesh_verts[poly.vertices[1]].co
-        rawp3 = mesh_verts[poly.vertices[2]].co
 
-        p1 = [rawp1[i] + offset[i] for i in range(0, 3)]
-        p2 = [rawp2[i] + offset[i] for i in range(0, 3)]
-        p3 = [rawp3[i] + offset[i] for i in range(0, 3)]
+def world_bounds(ob: Object):
+    """World space box around the object's bounding box corners, no mesh data needed"""
+    corners = np.array(
+        [tuple(ob.matrix_world @ Vector(corner)) for corner in ob.bound_box],
+        dtype=np.float32,
+    )
+    return (corners.min(axis=0), corners.max(axis=0))
 
-        uv = [
-            active_uv_layer[l].uv[:]
-            for l in range(poly.loop_start, poly.loop_start + poly.loop_total)
-        ]
 
-        uv1 = uv[0]
-        uv2 = uv[1]
-        uv3 = uv[2]
+def pathed_interior_key(ob: Object):
+    """Pathed objects with the same key have the same object space geometry and materials and share one build"""
+    original = ob.original
+    materials = tuple(object_materials(original))
+    if len(original.modifiers) != 0:
+        return ("object", original.name, materials)
+    return ("mesh", original.data.name, materials)
 
-        n = mesh_verts[poly.vertices[0]].normal
 
-        material = (
-            resolve_texture(mesh.materials[poly.material_index])
-            if poly.material_index != None
-            else "NULL"
-        )
+def build_pathed_interior(ob: Object, flip, double, cache_dir=None):
+    difbuilder = DifBuilder()
+    difbuilder.set_build_cache(cache_dir)
+    difbuilder.set_face_mode(flip, double)
+    mesh = ob.to_mesh()
+    mesh_triangulate(mesh)
 
-        if not flip:
-            difbuilder.add_triangle(p1, p2, p3, uv1, uv2, uv3, n, material)
-            if double:
-                difbuilder.add_triangle(p3, p2, p1, uv3, uv2, uv1, n, material)
-        else:
-            difbuilder.add_triangle(p3, p2, p1, uv3, uv2, uv1, n, material)
-            if double:
-                difbuilder.add_triangle(p1, p2, p3, uv1, uv2, uv3, n, material)
+    difbuilder.add_indexed_mesh(*mesh_indexed_buffers(mesh, ob))
+    return difbuilder
 
-    dif = difbuilder.build()
 
+def build_marker_list(marker_ob: Curve):
     marker_pts = (
         marker_ob.splines[0].bezier_points
         if (len(marker_ob.splines[0].bezier_points) != 0)
@@ -286,7 +823,47 @@ def build_pathed_interior(ob: Object, marker_ob: Curve, offset, flip, double):
     for pt in marker_pts:
         marker_list.push_marker(pt.co, msToNext, initialPathPosition)
 
-    return (dif, marker_list)
+    return marker_list
+
+
+def build_cache_dir():
+    import tempfile
+
+    cache_dir = os.path.join(tempfile.gettempdir(), "io_dif_cache")
+    os.makedirs(cache_dir, exist_ok=True)
+    return cache_dir
+
+
+def add_stats(total, stats):
+    """Sums build stats, peak memory is the largest of any single build"""
+    if total is None:
+        return dict(stats)
+    for (key, value) in stats.items():
+        if key == "peakAllocatedBytes":
+            total[key] = max(total[key], value)
+        else:
+            total[key] += value
+    return total
+
+
+class ExportProgress:
+    """Drives the window manager progress indicator, steps run on the main thread"""
+
+    def __init__(self, context, total):
+        self.wm = context.window_manager
+        self.current = 0
+        self.wm.progress_begin(0, max(total, 1))
+
+    def step(self):
+        self.current += 1
+        self.wm.progress_update(self.current)
+
+    def partial(self, fraction):
+        """Progress within the current step"""
+        self.wm.progress_update(self.current + fraction)
+
+    def end(self):
+        self.wm.progress_end()
 
 
 def build_game_entity(ob: Object):
@@ -311,136 +888,233 @@ def build_game_entity(ob: Object):
     )
 
 
-def save(
+# Yielded by save_steps while it only waits on native builds
+WAITING = "waiting"
+
+
+def wait_for(jobs, progress):
+    """Yields WAITING until every DifBuildJob in jobs is done"""
+    while len(jobs) != 0:
+        states = [job.poll() for job in jobs]
+        if all(done for (done, fraction) in states):
+            return
+        progress.partial(sum(fraction for (done, fraction) in states) / len(states))
+        yield WAITING
+
+
+def start_builds(chunks, jobs, limit):
+    """
+    Starts the [builder, job, dif] chunks not yet building, in order, while fewer
+    than limit of them build. limit 0 starts them all and leaves it to the native pool.
+    """
+    running = sum(1 for (builder, job, dif) in chunks if job is not None and dif is None)
+    for chunk in chunks:
+        if limit != 0 and running >= limit:
+            return
+        if chunk[1] is None:
+            chunk[1] = chunk[0].build_async()
+            jobs.append(chunk[1])
+            running += 1
+
+
+def save_steps(
     context: bpy.types.Context,
     filepath: str = "",
     flip=False,
     double=False,
-    maxtricount=16000,
+    maxtricount=0,
     applymodifiers=True,
     exportvisible=True,
     exportselected=False,
+    usecache=False,
+    streaming=False,
 ):
+    """
+    The export as a generator, so a modal operator can keep Blender responsive.
+    It yields after each unit of Python side work and WAITING while native builds
+    run, and returns the summed build stats. Closing it cancels the builds still running.
+    """
     import bpy
     import bmesh
 
     obs = bpy.context.selected_objects if exportselected else bpy.context.scene.objects
 
-    builders = [DifBuilder()]
+    cache_dir = build_cache_dir() if usecache else None
+    progress = ExportProgress(context, len(obs) + 3)
+    stats = None
+    jobs = []
 
-    difbuilder = builders[0]
+    difbuilder = DifBuilder()
+    difbuilder.set_build_cache(cache_dir)
+    difbuilder.set_face_mode(flip, double)
+    if streaming:
+        difbuilder.set_streaming()
 
     depsgraph = context.evaluated_depsgraph_get()
 
-    off = get_offset(depsgraph, applymodifiers)
-
-    tris = 0
-
-    def save_mesh(obj: Object, mesh: Mesh, offset, flip=False, double=False):
+    def save_mesh(obj: Object, mesh: Mesh):
         import bpy
 
-        nonlocal tris, difbuilder
-
+        # bmesh also gets concave polygons right, which the native fan does not
         mesh_triangulate(mesh)
 
-        mesh_verts = mesh.vertices
-
-        active_uv_layer = mesh.uv_layers.active.data
-
-        for poly in mesh.polygons:
-
-            if tris > maxtricount:
-                tris = 0
-                builders.append(DifBuilder())
-                difbuilder = builders[-1]
-
-            rawp1 = mesh_verts[poly.vertices[0]].co
-            rawp2 = mesh_verts[poly.vertices[1]].co
-            rawp3 = mesh_verts[poly.vertices[2]].co
-
-            p1 = [rawp1[i] + offset[i] for i in range(0, 3)]
-            p2 = [rawp2[i] + offset[i] for i in range(0, 3)]
-            p3 = [rawp3[i] + offset[i] for i in range(0, 3)]
-
-            uv = [
-                active_uv_layer[l].uv[:]
-                for l in range(poly.loop_start, poly.loop_start + poly.loop_total)
-            ]
-
-            uv1 = uv[0]
-            uv2 = uv[1]
-            uv3 = uv[2]
-
-            n = mesh_verts[poly.vertices[0]].normal
-
-            material = (
-                resolve_texture(mesh.materials[poly.material_index])
-                if poly.material_index != None
-                else "NULL"
-            )
-
-            if not flip:
-                difbuilder.add_triangle(p1, p2, p3, uv1, uv2, uv3, n, material)
-                tris += 1
-                if double:
-                    difbuilder.add_triangle(p3, p2, p1, uv3, uv2, uv1, n, material)
-                    tris += 1
-            else:
-                difbuilder.add_triangle(p3, p2, p1, uv3, uv2, uv1, n, material)
-                tris += 1
-                if double:
-                    difbuilder.add_triangle(p1, p2, p3, uv1, uv2, uv3, n, material)
-                    tris += 1
+        difbuilder.add_indexed_mesh(
+            *mesh_indexed_buffers(mesh, obj), matrix=obj.matrix_world
+        )
 
     mp_list = []
     game_entities: list[Object] = []
 
-    for ob in obs:
-        if exportvisible:
-            if not ob.visible_get():
-                continue
-
-        ob_eval = ob.evaluated_get(depsgraph) if applymodifiers else ob
+    try:
+        for ob in obs:
+            progress.step()
+            if exportvisible:
+                if not ob.visible_get():
+                    continue
 
-        dif_props = ob_eval.dif_props
+            ob_eval = ob.evaluated_get(depsgraph) if applymodifiers else ob
 
-        if dif_props.interior_type == "game_entity":
-            game_entities.append(ob_eval)
-
-        try:
-            me = ob_eval.to_mesh()
-        except RuntimeError:
-            continue
+            dif_props = ob_eval.dif_props
 
-        if dif_props.interior_type == "static_interior":
-            me.transform(ob_eval.matrix_world)
-            save_mesh(ob_eval, me, off, flip, double)
+            if dif_props.interior_type == "game_entity":
+                game_entities.append(ob_eval)
 
-        if dif_props.interior_type == "pathed_interior":
-            mp_list.append((ob_eval, dif_props.marker_path))
-
-    mp_difs = []
-
-    for (mp, curve) in mp_list:
-        mp_difs.append(build_pathed_interior(mp, curve, off, flip, double))
-
-    if tris != 0:
-        for i in range(0, len(builders)):
-            if i == 0:
-                for (mpdif, markerlist) in mp_difs:
-                    builders[i].add_pathed_interior(mpdif, markerlist)
-
-            dif = builders[i].build()
+            try:
+                me = ob_eval.to_mesh()
+            except RuntimeError:
+                continue
 
+            if dif_props.interior_type == "static_interior":
+                save_mesh(ob_eval, me)
+
+            # The triangles are native now, pathed interiors get their mesh again when built
+            ob_eval.to_mesh_clear()
+
+            if dif_props.interior_type == "pathed_interior":
+                mp_list.append((ob_eval, dif_props.marker_path))
+            yield
+
+        if difbuilder.triangle_count() == 0:
+            return stats
+
+        # Pathed interiors are submitted in object space but count towards the origin where they are placed
+        extra_bounds = [world_bounds(mp) for (mp, curve) in mp_list]
+        off = compute_shared_offset([difbuilder], extra_bounds)
+        difbuilder.set_offset(off)
+
+        # 0 starts from the largest budget the format limits allow, chunks still crossing one are split below
+        if maxtricount <= 0:
+            maxtricount = difbuilderlib.get_start_budget()
+        builders = difbuilder.partition(maxtricount)
+        stats = add_stats(stats, difbuilder.stats())
+        difbuilder = None
+
+        # Every build holds its chunk in DIFBuilder, so a streaming export builds one chunk at a time
+        build_limit = 1 if streaming else 0
+
+        # The first chunk carries the pathed interiors, the rest build while those are extracted
+        chunks = [[builder, None, None] for builder in builders]
+        start_builds(chunks[1:], jobs, build_limit)
+
+        # One build per distinct mesh, every follower of it then shares the built sub object
+        progress.step()
+        mp_keys = [pathed_interior_key(mp) for (mp, curve) in mp_list]
+        mp_builders = {}
+        mp_jobs = {}
+        for (key, (mp, curve)) in zip(mp_keys, mp_list):
+            if key not in mp_builders:
+                mp_builders[key] = build_pathed_interior(mp, flip, double, cache_dir)
+                mp_builders[key].set_offset(off)
+                mp_jobs[key] = mp_builders[key].build_async()
+                jobs.append(mp_jobs[key])
+                yield
+        mp_markers = [build_marker_list(curve) for (mp, curve) in mp_list]
+
+        yield from wait_for(list(mp_jobs.values()), progress)
+        mp_difs = {}
+        for (key, job) in mp_jobs.items():
+            jobs.remove(job)
+            mp_difs[key] = job.wait()
+            stats = add_stats(stats, mp_builders[key].stats())
+
+        for (key, markerlist) in zip(mp_keys, mp_markers):
+            builders[0].add_pathed_interior(mp_difs[key], markerlist)
+
+        # Chunks crossing a DIF format limit are split further and built again, so files are numbered once all fit
+        progress.step()
+        while any(dif is None for (builder, job, dif) in chunks):
+            start_builds(chunks, jobs, build_limit)
+            for chunk in [c for c in chunks if c[2] is None and c[1] is not None and c[1].poll()[0]]:
+                (builder, job) = (chunk[0], chunk[1])
+                jobs.remove(job)
+                dif = job.wait()
+                budget = builder.split_budget(dif)
+                if budget == 0:
+                    chunk[2] = dif
+                    stats = add_stats(stats, builder.stats())
+                    continue
+
+                parts = [[part, None, None] for part in builder.partition(budget)]
+                at = next(i for (i, c) in enumerate(chunks) if c is chunk)
+                chunks[at : at + 1] = parts
+
+            running = [job.poll()[1] if job is not None else 0.0 for (builder, job, dif) in chunks if dif is None]
+            if len(running) != 0:
+                progress.partial((len(chunks) - len(running) + sum(running)) / len(chunks))
+                yield WAITING
+
+        writes = []
+        for (i, (builder, job, dif)) in enumerate(chunks):
             if i == 0:
                 for ge in game_entities:
                     entity = build_game_entity(ge)
                     dif.add_game_entity(
                         entity[1],
                         entity[0],
-                        [ge.location[i] + off[i] for i in range(0, 3)],
+                        [ge.location[j] + off[j] for j in range(0, 3)],
                         entity[3],
                         entity[2],
                     )
 
-            dif.write_dif(str(Path(filepath).with_suffix("")) + str(i) + ".dif")
+            writes.append(
+                dif.write_async(str(Path(filepath).with_suffix("")) + str(i) + ".dif")
+            )
+
+        progress.step()
+        for job in writes:
+            job.wait()
+    finally:
+        for job in jobs:
+            job.cancel()
+        for job in jobs:
+            try:
+                job.wait()
+            except Exception:
+                pass
+        progress.end()
+
+    return stats
+
+
+def advance(steps, budget):
+    """
+    Runs a save_steps generator for up to budget seconds, or until it waits on
+    native builds. Returns (finished, stats).
+    """
+    end = time.perf_counter() + budget
+    try:
+        while next(steps) != WAITING and time.perf_counter() < end:
+            pass
+    except StopIteration as done:
+        return (True, done.value)
+    return (False, None)
+
+
+def save(context: bpy.types.Context, *args, **kwargs):
+    """Runs the whole export before returning, see save_steps for the arguments"""
+    steps = save_steps(context, *args, **kwargs)
+    while True:
+        (finished, stats) = advance(steps, 0.1)
+        if finished:
+            return stats
+        time.sleep(0.005)
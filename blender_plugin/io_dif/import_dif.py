@@ -1,17 +1,252 @@
 import array
+import ctypes
 import os
 import time
 import bpy
+import numpy as np
 from bpy.props import CollectionProperty
 from bpy.types import Curve, Object
 import mathutils
-from .hxDif import *
 from bpy_extras.io_utils import unpack_list
 from bpy_extras.image_utils import load_image
 from .util import default_materials, resolve_texture, get_rgb_colors
 
 from bpy_extras.wm_utils.progress_report import ProgressReport, ProgressReportSubstep
 
+dllpath = os.path.join(os.path.dirname(os.path.realpath(__file__)), "DifBuilderLib.dll")
+difbuilderlib = None
+try:
+    difbuilderlib = ctypes.CDLL(dllpath)
+except:
+    raise Exception(
+        "There was an error loading the necessary dll required for dif import. Please download the plugin from the proper location: https://github.com/RandomityGuy/io_dif/releases"
+    )
+
+c_float_p = ctypes.POINTER(ctypes.c_float)
+c_int_p = ctypes.POINTER(ctypes.c_int)
+
+difbuilderlib.read_dif.argtypes = [ctypes.c_char_p]
+difbuilderlib.read_dif.restype = ctypes.c_void_p
+difbuilderlib.read_dif_filtered.argtypes = [ctypes.c_char_p, ctypes.c_int]
+difbuilderlib.read_dif_filtered.restype = ctypes.c_void_p
+
+# DifBuilderLib::DifSection
+DIF_SECTION_INTERIORS = 1
+DIF_SECTION_SUB_OBJECTS = 2
+DIF_SECTION_PATH_FOLLOWERS = 4
+DIF_SECTION_GAME_ENTITIES = 8
+DIF_SECTION_TRIGGERS = 16
+DIF_SECTION_LIGHTMAPS = 32
+
+# Everything the importer turns into Blender data. Lightmaps and triggers are never used,
+# they are still parsed but freed right after
+IMPORT_SECTIONS = (
+    DIF_SECTION_INTERIORS
+    | DIF_SECTION_SUB_OBJECTS
+    | DIF_SECTION_PATH_FOLLOWERS
+    | DIF_SECTION_GAME_ENTITIES
+)
+difbuilderlib.dispose_dif.argtypes = [ctypes.c_void_p]
+
+for name in ("get_interior", "get_sub_object"):
+    getattr(difbuilderlib, name).argtypes = [ctypes.c_void_p, ctypes.c_int]
+    getattr(difbuilderlib, name).restype = ctypes.c_void_p
+
+for name in (
+    "get_interior_count",
+    "get_sub_object_count",
+    "get_path_follower_count",
+    "get_game_entity_count",
+    "get_material_count",
+    "get_dict_count",
+):
+    getattr(difbuilderlib, name).argtypes = [ctypes.c_void_p]
+    getattr(difbuilderlib, name).restype = ctypes.c_int
+
+for name in (
+    "get_path_follower_name",
+    "get_path_follower_datablock",
+    "get_game_entity_class",
+    "get_game_entity_datablock",
+    "get_material_name",
+    "get_dict_key",
+    "get_dict_value",
+):
+    getattr(difbuilderlib, name).argtypes = [ctypes.c_void_p, ctypes.c_int]
+    getattr(difbuilderlib, name).restype = ctypes.c_char_p
+
+for name in ("get_path_follower_properties", "get_game_entity_properties"):
+    getattr(difbuilderlib, name).argtypes = [ctypes.c_void_p, ctypes.c_int]
+    getattr(difbuilderlib, name).restype = ctypes.c_void_p
+
+for name in ("get_path_follower_interior", "get_path_follower_waypoint_count"):
+    getattr(difbuilderlib, name).argtypes = [ctypes.c_void_p, ctypes.c_int]
+    getattr(difbuilderlib, name).restype = ctypes.c_int
+
+difbuilderlib.get_mesh_sizes.argtypes = [ctypes.c_void_p, c_int_p, c_int_p]
+difbuilderlib.extract_mesh.argtypes = [
+    ctypes.c_void_p,
+    c_float_p,
+    c_int_p,
+    c_float_p,
+    c_int_p,
+    c_float_p,
+]
+difbuilderlib.get_path_follower_offset.argtypes = [
+    ctypes.c_void_p,
+    ctypes.c_int,
+    c_float_p,
+]
+difbuilderlib.get_path_follower_waypoints.argtypes = [
+    ctypes.c_void_p,
+    ctypes.c_int,
+    c_float_p,
+    c_float_p,
+    c_int_p,
+    c_int_p,
+]
+difbuilderlib.get_game_entity_position.argtypes = [
+    ctypes.c_void_p,
+    ctypes.c_int,
+    c_float_p,
+]
+
+
+def _read_dict(dictptr):
+    return {
+        difbuilderlib.get_dict_key(dictptr, i)
+        .decode("ascii", "replace"): difbuilderlib.get_dict_value(dictptr, i)
+        .decode("ascii", "replace")
+        for i in range(difbuilderlib.get_dict_count(dictptr))
+    }
+
+
+def _ptr(arr, ctype):
+    return arr.ctypes.data_as(ctypes.POINTER(ctype))
+
+
+class Interior:
+    """Mesh buffers of one DIF interior, triangulated by the native reader."""
+
+    def __init__(self, ptr):
+        lib = difbuilderlib
+
+        self.materialList = [
+            lib.get_material_name(ptr, i).decode("ascii", "replace")
+            for i in range(lib.get_material_count(ptr))
+        ]
+
+        vertex_count = ctypes.c_int()
+        triangle_count = ctypes.c_int()
+        lib.get_mesh_sizes(ptr, ctypes.byref(vertex_count), ctypes.byref(triangle_count))
+
+        self.positions = np.empty(vertex_count.value * 3, dtype=np.float32)
+        self.loopVertices = np.empty(triangle_count.value * 3, dtype=np.int32)
+        self.loopUVs = np.empty(triangle_count.value * 6, dtype=np.float32)
+        self.polyMaterials = np.empty(triangle_count.value, dtype=np.int32)
+        lib.extract_mesh(
+            ptr,
+            _ptr(self.positions, ctypes.c_float),
+            _ptr(self.loopVertices, ctypes.c_int),
+            _ptr(self.loopUVs, ctypes.c_float),
+            _ptr(self.polyMaterials, ctypes.c_int),
+            None,
+        )
+
+
+class WayPoint:
+    def __init__(self, position, rotation, msToNext, smoothingType):
+        self.position = position
+        self.rotation = rotation
+        self.msToNext = msToNext
+        self.smoothingType = smoothingType
+
+
+class InteriorPathFollower:
+    def __init__(self, difptr, index):
+        lib = difbuilderlib
+
+        self.name = lib.get_path_follower_name(difptr, index).decode("ascii", "replace")
+        self.datablock = lib.get_path_follower_datablock(difptr, index).decode(
+            "ascii", "replace"
+        )
+        self.interiorResIndex = lib.get_path_follower_interior(difptr, index)
+
+        offset = (ctypes.c_float * 3)()
+        lib.get_path_follower_offset(difptr, index, offset)
+        self.offset = tuple(offset)
+
+        self.properties = _read_dict(lib.get_path_follower_properties(difptr, index))
+
+        count = lib.get_path_follower_waypoint_count(difptr, index)
+        positions = (ctypes.c_float * (count * 3))()
+        rotations = (ctypes.c_float * (count * 4))()
+        msToNext = (ctypes.c_int * count)()
+        smoothing = (ctypes.c_int * count)()
+        lib.get_path_follower_waypoints(
+            difptr, index, positions, rotations, msToNext, smoothing
+        )
+        self.wayPoint = [
+            WayPoint(
+                tuple(positions[i * 3 : i * 3 + 3]),
+                tuple(rotations[i * 4 : i * 4 + 4]),
+                msToNext[i],
+                smoothing[i],
+            )
+            for i in range(count)
+        ]
+
+
+class GameEntity:
+    def __init__(self, difptr, index):
+        lib = difbuilderlib
+
+        self.gameClass = lib.get_game_entity_class(difptr, index).decode(
+            "ascii", "replace"
+        )
+        self.datablock = lib.get_game_entity_datablock(difptr, index).decode(
+            "ascii", "replace"
+        )
+
+        position = (ctypes.c_float * 3)()
+        lib.get_game_entity_position(difptr, index, position)
+        self.position = tuple(position)
+
+        self.properties = _read_dict(lib.get_game_entity_properties(difptr, index))
+
+
+class Dif:
+    """A DIF file read by DifBuilderLib, with every section the importer uses copied out."""
+
+    def __init__(self, ptr):
+        lib = difbuilderlib
+
+        self.interiors = [
+            Interior(lib.get_interior(ptr, i))
+            for i in range(lib.get_interior_count(ptr))
+        ]
+        self.subObjects = [
+            Interior(lib.get_sub_object(ptr, i))
+            for i in range(lib.get_sub_object_count(ptr))
+        ]
+        self.interiorPathfollowers = [
+            InteriorPathFollower(ptr, i)
+            for i in range(lib.get_path_follower_count(ptr))
+        ]
+        self.gameEntities = [
+            GameEntity(ptr, i) for i in range(lib.get_game_entity_count(ptr))
+        ]
+
+    @staticmethod
+    def Load(path, sections=IMPORT_SECTIONS):
+        ptr = difbuilderlib.read_dif_filtered(path.encode("utf-8"), sections)
+        if ptr == None:
+            raise Exception("Could not read DIF file: " + path)
+        try:
+            return Dif(ptr)
+        finally:
+            difbuilderlib.dispose_dif(ptr)
+
 
 def create_material(filepath, matname):
     if "/" in matname:
@@ -46,103 +281,26 @@ def create_mesh(filepath, interior: Interior):
     """
     me = bpy.data.meshes.new("Mesh")
 
-    faces = []
-
-    normals = []
-    tex_coords = []
-
-    indices = []
-
     for mat in interior.materialList:
         me.materials.append(create_material(filepath, mat))
 
-    for surface in interior.surfaces:
-        for i in range(0, surface.windingCount - 2):
-            if i % 2 == 0:
-                index0 = interior.windings[i + surface.windingStart + 2]
-                index1 = interior.windings[i + surface.windingStart + 1]
-                index2 = interior.windings[i + surface.windingStart]
-            else:
-                index0 = interior.windings[i + surface.windingStart]
-                index1 = interior.windings[i + surface.windingStart + 1]
-                index2 = interior.windings[i + surface.windingStart + 2]
-
-            plane_flipped = (surface.planeIndex & 0x8000) == 0x8000
-            normal_index = interior.planes[surface.planeIndex & ~0x8000].normalIndex
-            tex_gen = interior.texGenEQs[surface.texGenIndex]
-
-            normal = interior.normals[normal_index]
-            if plane_flipped:
-                normal.x *= -1
-                normal.y *= -1
-                normal.z *= -1
-
-            pt0 = interior.points[index0]
-            pt1 = interior.points[index1]
-            pt2 = interior.points[index2]
-
-            def plane_to_uv(pt, plane):
-                return pt.x * plane.x + pt.y * plane.y + pt.z * plane.z + plane.d
-
-            coord0 = [
-                plane_to_uv(pt0, tex_gen.planeX),
-                plane_to_uv(pt0, tex_gen.planeY),
-            ]
-            coord1 = [
-                plane_to_uv(pt1, tex_gen.planeX),
-                plane_to_uv(pt1, tex_gen.planeY),
-            ]
-            coord2 = [
-                plane_to_uv(pt2, tex_gen.planeX),
-                plane_to_uv(pt2, tex_gen.planeY),
-            ]
-
-            indices.append((index0, len(normals), len(tex_coords)))
-            normals.append(normal)
-            tex_coords.append(coord0)
-
-            indices.append((index1, len(normals), len(tex_coords)))
-            normals.append(normal)
-            tex_coords.append(coord1)
-
-            indices.append((index2, len(normals), len(tex_coords)))
-            normals.append(normal)
-            tex_coords.append(coord2)
-
-            faces.append(
-                (
-                    (len(indices) - 3, len(indices) - 2, len(indices) - 1),
-                    surface.textureIndex,
-                )
-            )
+    triangle_count = len(interior.polyMaterials)
 
-    me.vertices.add(len(interior.points))
-    for i in range(0, len(interior.points)):
-        me.vertices[i].co = [
-            interior.points[i].x,
-            interior.points[i].y,
-            interior.points[i].z,
-        ]
-        me.vertices[i].normal = [normals[i].x, normals[i].y, normals[i].z]
+    me.vertices.add(len(interior.positions) // 3)
+    me.vertices.foreach_set("co", interior.positions)
 
-    me.polygons.add(len(faces))
-    me.loops.add(len(faces) * 3)
+    me.loops.add(triangle_count * 3)
+    me.loops.foreach_set("vertex_index", interior.loopVertices)
 
-    me.uv_layers.new()
-    uvs = me.uv_layers[0]
+    me.polygons.add(triangle_count)
+    me.polygons.foreach_set(
+        "loop_start", np.arange(0, triangle_count * 3, 3, dtype=np.int32)
+    )
+    me.polygons.foreach_set("loop_total", np.full(triangle_count, 3, dtype=np.int32))
+    me.polygons.foreach_set("material_index", interior.polyMaterials)
 
-    for i, ((verts, material), poly) in enumerate(zip(faces, me.polygons)):
-        poly.loop_total = 3
-        poly.loop_start = i * 3
-
-        poly.material_index = material
-
-        for j, index in zip(poly.loop_indices, verts):
-            me.loops[j].vertex_index = indices[index][0]
-            uvs.data[j].uv = (
-                tex_coords[indices[index][1]][0],
-                tex_coords[indices[index][1]][1],
-            )
+    me.uv_layers.new()
+    me.uv_layers[0].data.foreach_set("uv", interior.loopUVs)
 
     me.validate()
     me.update()
@@ -207,15 +365,12 @@ def load(
         itr = pathedInteriors[mover.interiorResIndex]
         itr: Object = itr.copy()
         base = scene.collection.objects.link(itr)
-        itr.location = [pos.x, pos.y, pos.z]
+        itr.location = pos
         itr.dif_props.interior_type = "pathed_interior"
 
         waypoints: list[WayPoint] = mover.wayPoint
 
-        markerpts = [
-            (waypt.position.x, waypt.position.y, waypt.position.z)
-            for waypt in waypoints
-        ]
+        markerpts = [waypt.position for waypt in waypoints]
 
         curve = bpy.data.curves.new("markers", type="CURVE")
         curve.dimensions = "3D"
@@ -236,14 +391,14 @@ def load(
         for ge in dif.gameEntities:
             g: GameEntity = ge
             gobj = bpy.data.objects.new(g.datablock, None)
-            gobj.location = (g.position.x, g.position.y, g.position.z)
+            gobj.location = g.position
             gobj.dif_props.interior_type = "game_entity"
             gobj.dif_props.game_entity_datablock = g.datablock
             gobj.dif_props.game_entity_gameclass = g.gameClass
-            for key in g.properties.h:
+            for key in g.properties:
                 prop = gobj.dif_props.game_entity_properties.add()
                 prop.key = key
-                prop.value = g.properties.get(key)
+                prop.value = g.properties[key]
             scene.collection.objects.link(gobj)
 
     context.view_layer.update()
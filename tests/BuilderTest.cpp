@@ -0,0 +1,35 @@
+#include "Interiors.h"
+#include "Test.h"
+#include "Writer.h"
+
+using namespace DifBuilderLibTests;
+
+namespace
+{
+	std::vector<char> buildGrid(size_t spillThreshold)
+	{
+		DifBuilderLib::Builder builder;
+		builder.spillThreshold = spillThreshold;
+		builder.mergeSurfaces = true;
+		builder.optimizeLayout = true;
+		addGrid(builder, 24);
+		CHECK((spillThreshold > 0) == !builder.spilled.empty());
+
+		DIF::DIF dif;
+		CHECK(builder.build(dif));
+		CHECK(builder.triangleCount() == 24 * 24 * 2);
+		CHECK((spillThreshold > 0) == !builder.spilled.empty());
+		std::vector<char> data;
+		CHECK(DifBuilderLib::serialize(dif, data));
+		return data;
+	}
+}
+
+// Paging the triangles back from the spill file hands DIFBuilder the same triangles in the same order
+TEST(spilled_build_matches)
+{
+	std::vector<char> inMemory = buildGrid(0);
+	CHECK(!inMemory.empty());
+	CHECK(buildGrid(100) == inMemory);
+	CHECK(buildGrid(1) == inMemory);
+}
@@ -0,0 +1,117 @@
+#include "Cache.h"
+#include "Interiors.h"
+#include "Test.h"
+#include "Writer.h"
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <sys/utime.h>
+#else
+#include <sys/stat.h>
+#include <utime.h>
+#endif
+
+using namespace DifBuilderLibTests;
+
+namespace
+{
+	const char *CacheDir = "cache_test";
+
+	void makeDir(const char *path)
+	{
+#ifdef _WIN32
+		_mkdir(path);
+#else
+		mkdir(path, 0755);
+#endif
+	}
+
+	bool exists(const std::string &path)
+	{
+		return std::ifstream(path.c_str()).good();
+	}
+
+	void writeAged(const std::string &path, long long ageSeconds)
+	{
+		std::ofstream(path.c_str()) << "partial";
+#ifdef _WIN32
+		struct _utimbuf times;
+		times.actime = times.modtime = (time_t)(time(NULL) - ageSeconds);
+		_utime(path.c_str(), &times);
+#else
+		struct utimbuf times;
+		times.actime = times.modtime = (time_t)(time(NULL) - ageSeconds);
+		utime(path.c_str(), &times);
+#endif
+	}
+
+	// Builds a grid through the cache, hit says whether it was loaded from there. clear first removes an entry
+	// an earlier run stored for it
+	std::vector<char> buildCached(int size, bool clear, bool &hit)
+	{
+		DifBuilderLib::Builder builder;
+		builder.cacheDir = CacheDir;
+		addGrid(builder, size);
+		DifBuilderLib::CacheKey key;
+		if (clear && builder.cacheKey(key))
+			std::remove(DifBuilderLib::cachePath(CacheDir, key).c_str());
+
+		DIF::DIF dif;
+		CHECK(builder.build(dif));
+		hit = builder.stats.cacheHit != 0;
+		std::vector<char> data;
+		CHECK(DifBuilderLib::serialize(dif, data));
+		return data;
+	}
+}
+
+// The second build of the same inputs loads what the first stored, other inputs miss
+TEST(cache_hit_miss)
+{
+	makeDir(CacheDir);
+	bool hit = true;
+	std::vector<char> built = buildCached(8, true, hit);
+	CHECK(!hit);
+	std::vector<char> loaded = buildCached(8, false, hit);
+	CHECK(hit);
+	CHECK(loaded == built);
+	buildCached(9, true, hit);
+	CHECK(!hit);
+
+	// An entry stored for other inputs under the same name is a miss
+	DifBuilderLib::CacheKey key;
+	key.hash = 1;
+	std::string path = DifBuilderLib::cachePath(CacheDir, key);
+	DifBuilderLib::storeCached(CacheDir, path, key, DIF::DIF());
+	DIF::DIF dif;
+	CHECK(DifBuilderLib::loadCached(path, key, dif));
+	key.check = 2;
+	CHECK(!DifBuilderLib::loadCached(path, key, dif));
+	std::remove(path.c_str());
+}
+
+// Temporary files of stores that never finished go once they are stale, fresh ones and other files stay
+TEST(cache_prune_temp_files)
+{
+	makeDir(CacheDir);
+	DifBuilderLib::CacheKey key;
+	key.hash = 0x0123456789abcdefULL;
+	std::string entry = DifBuilderLib::cachePath(CacheDir, key);
+	std::string stale = entry + ".1.tmp";
+	std::string fresh = entry + ".2.tmp";
+	std::string other = std::string(CacheDir) + "/notes.tmp";
+	writeAged(stale, 2 * 60 * 60);
+	writeAged(fresh, 0);
+	writeAged(other, 2 * 60 * 60);
+
+	DifBuilderLib::pruneCache(CacheDir);
+	CHECK(!exists(stale));
+	CHECK(exists(fresh));
+	CHECK(exists(other));
+
+	std::remove(fresh.c_str());
+	std::remove(other.c_str());
+}
@@ -0,0 +1,278 @@
+#include "Interiors.h"
+#include "Test.h"
+#include <cmath>
+
+namespace DifBuilderLibTests
+{
+	namespace
+	{
+		const U32 PlaneFlipFlag = 0x8000;
+		const U32 NullSurfaceFlag = 0x80000000;
+		const U32 NoLightMap = 0xFF;
+
+		U16 addPlane(DIF::Interior &interior, const glm::vec3 &normal, float distance)
+		{
+			DIF::Interior::Plane plane;
+			plane.normalIndex = (U16)interior.normal.size();
+			plane.planeDistance = distance;
+			interior.normal.push_back(normal);
+			interior.plane.push_back(plane);
+			return (U16)(interior.plane.size() - 1);
+		}
+
+		U32 addWinding(DIF::Interior &interior, const glm::vec3 *points, int count)
+		{
+			U32 start = (U32)interior.index.size();
+			for (int i = 0; i < count; i++)
+			{
+				interior.index.push_back((U32)interior.point.size());
+				interior.point.push_back(points[i]);
+			}
+			return start;
+		}
+
+		void addTriangle(DIF::Interior &interior, const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c, bool lit)
+		{
+			glm::vec3 corners[3] = {a, b, c};
+
+			DIF::Interior::TexGenEq texGen;
+			texGen.planeX = {1.0f, 0.0f, 0.0f, 0.0f};
+			texGen.planeY = {0.0f, 1.0f, 0.0f, 0.0f};
+			interior.texGenEq.push_back(texGen);
+
+			DIF::Interior::Surface surface = DIF::Interior::Surface();
+			surface.windingStart = addWinding(interior, corners, 3);
+			surface.windingCount = 3;
+			surface.planeIndex = addPlane(interior, glm::vec3(0.0f, 0.0f, 1.0f), 0.0f);
+			surface.planeFlipped = false;
+			surface.textureIndex = 0;
+			surface.texGenIndex = (U32)(interior.texGenEq.size() - 1);
+			surface.fanMask = 7;
+			U32 surfaceIndex = (U32)interior.surface.size();
+			interior.surface.push_back(surface);
+			interior.normalLMapIndex.push_back(lit ? 0 : NoLightMap);
+			interior.alarmLMapIndex.push_back(NoLightMap);
+
+			DIF::Interior::ConvexHull hull = DIF::Interior::ConvexHull();
+			hull.hullStart = (U32)interior.hullIndex.size();
+			hull.hullCount = 3;
+			hull.surfaceStart = (U32)interior.hullSurfaceIndex.size();
+			hull.surfaceCount = 1;
+			hull.planeStart = (U32)interior.hullPlaneIndex.size();
+			hull.polyListPlaneStart = (U32)interior.polyListPlaneIndex.size();
+			hull.polyListPointStart = (U32)interior.polyListPointIndex.size();
+			hull.minX = std::fmin(a.x, std::fmin(b.x, c.x));
+			hull.maxX = std::fmax(a.x, std::fmax(b.x, c.x));
+			hull.minY = std::fmin(a.y, std::fmin(b.y, c.y));
+			hull.maxY = std::fmax(a.y, std::fmax(b.y, c.y));
+			for (int i = 0; i < 3; i++)
+			{
+				interior.hullIndex.push_back(interior.index[surface.windingStart + i]);
+				interior.polyListPointIndex.push_back(interior.index[surface.windingStart + i]);
+			}
+			interior.hullSurfaceIndex.push_back(surfaceIndex);
+			interior.hullPlaneIndex.push_back(surface.planeIndex);
+			interior.polyListPlaneIndex.push_back(surface.planeIndex);
+			interior.convexHull.push_back(hull);
+		}
+	}
+
+	DIF::Interior gridInterior(int size)
+	{
+		DIF::Interior interior;
+		interior.materialName.push_back("grid");
+		interior.lightMap.resize(1);
+
+		for (int y = 0; y < size; y++)
+		{
+			for (int x = 0; x < size; x++)
+			{
+				glm::vec3 p00((float)x, (float)y, 0.0f);
+				glm::vec3 p10((float)x + 1, (float)y, 0.0f);
+				glm::vec3 p11((float)x + 1, (float)y + 1, 0.0f);
+				glm::vec3 p01((float)x, (float)y + 1, 0.0f);
+				bool lit = y == size - 1;
+				addTriangle(interior, p00, p10, p11, lit);
+				addTriangle(interior, p00, p11, p01, lit);
+			}
+		}
+		U32 surfaceCount = (U32)interior.surface.size();
+
+		// Null surface under the grid, on a downward plane referred to flipped
+		float s = (float)size;
+		glm::vec3 outline[4] = {glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, s, 0.0f), glm::vec3(s, s, 0.0f), glm::vec3(s, 0.0f, 0.0f)};
+		DIF::Interior::NullSurface nullSurface = DIF::Interior::NullSurface();
+		nullSurface.windingStart = addWinding(interior, outline, 4);
+		nullSurface.windingCount = 4;
+		nullSurface.planeIndex = (U16)(addPlane(interior, glm::vec3(0.0f, 0.0f, -1.0f), 0.0f) | PlaneFlipFlag);
+		interior.nullSurface.push_back(nullSurface);
+
+		// Portal standing on the grid's edge
+		glm::vec3 fan[3] = {glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, s, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)};
+		DIF::Interior::WindingIndex triFan;
+		triFan.windingStart = addWinding(interior, fan, 3);
+		triFan.windingCount = 3;
+		interior.windingIndex.push_back(triFan);
+		DIF::Interior::Portal portal = DIF::Interior::Portal();
+		portal.planeIndex = addPlane(interior, glm::vec3(1.0f, 0.0f, 0.0f), 0.0f);
+		portal.triFanStart = 0;
+		portal.triFanCount = 1;
+		interior.portal.push_back(portal);
+
+		DIF::Interior::BSPNode node = DIF::Interior::BSPNode();
+		node.planeIndex = interior.surface[0].planeIndex;
+		interior.bspNode.push_back(node);
+
+		DIF::Interior::BSPSolidLeaf leaf;
+		leaf.surfaceIndex = 0;
+		leaf.surfaceCount = (U16)(surfaceCount + 1);
+		interior.bspSolidLeaf.push_back(leaf);
+		for (U32 i = 0; i < surfaceCount; i++)
+			interior.solidLeafSurface.push_back(i);
+		interior.solidLeafSurface.push_back(NullSurfaceFlag);
+
+		DIF::Interior::Zone zone = DIF::Interior::Zone();
+		zone.portalCount = 1;
+		zone.surfaceCount = surfaceCount;
+		interior.zone.push_back(zone);
+		for (U32 i = 0; i < surfaceCount; i++)
+			interior.zoneSurface.push_back((U16)i);
+
+		return interior;
+	}
+
+	glm::vec4 resolvePlane(const DIF::Interior &interior, U32 reference)
+	{
+		const DIF::Interior::Plane &plane = interior.plane[reference & ~PlaneFlipFlag];
+		glm::vec4 resolved(interior.normal[plane.normalIndex], plane.planeDistance);
+		if (reference & PlaneFlipFlag)
+			resolved = glm::vec4(-resolved.x, -resolved.y, -resolved.z, -resolved.w);
+		return resolved;
+	}
+
+	std::vector<glm::vec3> windingPoints(const DIF::Interior &interior, U32 start, U32 count)
+	{
+		std::vector<glm::vec3> points;
+		for (U32 i = start; i < start + count; i++)
+			points.push_back(interior.point[interior.index[i]]);
+		return points;
+	}
+
+	float surfaceArea(const DIF::Interior &interior)
+	{
+		float area = 0.0f;
+		for (const DIF::Interior::Surface &surface : interior.surface)
+		{
+			for (U32 i = 2; i < surface.windingCount; i++)
+			{
+				const glm::vec3 &a = interior.point[interior.index[surface.windingStart + i - 2]];
+				const glm::vec3 &b = interior.point[interior.index[surface.windingStart + i - 1]];
+				const glm::vec3 &c = interior.point[interior.index[surface.windingStart + i]];
+				area += glm::length(glm::cross(b - a, c - a)) * 0.5f;
+			}
+		}
+		return area;
+	}
+
+	void checkInterior(const DIF::Interior &interior)
+	{
+		size_t points = interior.point.size();
+		size_t planes = interior.plane.size();
+		size_t surfaces = interior.surface.size();
+
+		for (const DIF::Interior::Plane &plane : interior.plane)
+			CHECK(plane.normalIndex < interior.normal.size());
+		for (U32 index : interior.index)
+			CHECK(index < points);
+
+		for (const DIF::Interior::Surface &surface : interior.surface)
+		{
+			CHECK(surface.windingCount >= 3);
+			CHECK((size_t)surface.windingStart + surface.windingCount <= interior.index.size());
+			CHECK(surface.planeIndex < planes);
+			CHECK(surface.texGenIndex < interior.texGenEq.size());
+			CHECK(surface.textureIndex < interior.materialName.size());
+		}
+		for (const DIF::Interior::NullSurface &surface : interior.nullSurface)
+		{
+			CHECK((size_t)surface.windingStart + surface.windingCount <= interior.index.size());
+			CHECK((surface.planeIndex & ~PlaneFlipFlag) < planes);
+		}
+		for (const DIF::Interior::WindingIndex &fan : interior.windingIndex)
+			CHECK((size_t)fan.windingStart + fan.windingCount <= interior.index.size());
+		for (const DIF::Interior::Portal &portal : interior.portal)
+		{
+			CHECK((portal.planeIndex & ~PlaneFlipFlag) < planes);
+			CHECK((size_t)portal.triFanStart + portal.triFanCount <= interior.windingIndex.size());
+		}
+
+		// The lightmap index arrays run parallel to the surfaces
+		CHECK(interior.normalLMapIndex.size() == surfaces);
+		CHECK(interior.alarmLMapIndex.size() == surfaces);
+
+		for (const DIF::Interior::BSPNode &node : interior.bspNode)
+			CHECK((node.planeIndex & ~PlaneFlipFlag) < planes);
+		for (const DIF::Interior::BSPSolidLeaf &leaf : interior.bspSolidLeaf)
+			CHECK((size_t)leaf.surfaceIndex + leaf.surfaceCount <= interior.solidLeafSurface.size());
+		for (U32 reference : interior.solidLeafSurface)
+		{
+			if (reference & NullSurfaceFlag)
+				CHECK((reference & ~NullSurfaceFlag) < interior.nullSurface.size());
+			else
+				CHECK(reference < surfaces);
+		}
+
+		for (const DIF::Interior::ConvexHull &hull : interior.convexHull)
+		{
+			CHECK((size_t)hull.hullStart + hull.hullCount <= interior.hullIndex.size());
+			CHECK((size_t)hull.surfaceStart + hull.surfaceCount <= interior.hullSurfaceIndex.size());
+			CHECK(hull.planeStart <= interior.hullPlaneIndex.size());
+			CHECK(hull.polyListPlaneStart <= interior.polyListPlaneIndex.size());
+			CHECK(hull.polyListPointStart <= interior.polyListPointIndex.size());
+		}
+		for (U32 index : interior.hullIndex)
+			CHECK(index < points);
+		for (U32 index : interior.polyListPointIndex)
+			CHECK(index < points);
+		for (U16 index : interior.hullPlaneIndex)
+			CHECK((index & ~PlaneFlipFlag) < planes);
+		for (U16 index : interior.polyListPlaneIndex)
+			CHECK((index & ~PlaneFlipFlag) < planes);
+		for (U32 reference : interior.hullSurfaceIndex)
+		{
+			if (reference & NullSurfaceFlag)
+				CHECK((reference & ~NullSurfaceFlag) < interior.nullSurface.size());
+			else
+				CHECK(reference < surfaces);
+		}
+
+		for (const DIF::Interior::Zone &zone : interior.zone)
+			CHECK((size_t)zone.surfaceStart + zone.surfaceCount <= interior.zoneSurface.size());
+		for (U16 index : interior.zoneSurface)
+			CHECK(index < surfaces);
+	}
+
+	void addGrid(DifBuilderLib::Builder &builder, int size)
+	{
+		int materials[2] = {builder.registerMaterial("grid"), builder.registerMaterial("other")};
+		for (int y = 0; y < size; y++)
+		{
+			for (int x = 0; x < size; x++)
+			{
+				glm::vec3 corners[4] = {glm::vec3((float)x, (float)y, 0.0f), glm::vec3((float)x + 1, (float)y, 0.0f), glm::vec3((float)x + 1, (float)y + 1, 0.0f), glm::vec3((float)x, (float)y + 1, 0.0f)};
+				int fans[2][3] = {{0, 1, 2}, {0, 2, 3}};
+				for (int k = 0; k < 2; k++)
+				{
+					DIF::DIFBuilder::Triangle tri;
+					for (int j = 0; j < 3; j++)
+					{
+						tri.points[j].vertex = corners[fans[k][j]];
+						tri.points[j].uv = glm::vec2(corners[fans[k][j]].x, corners[fans[k][j]].y);
+						tri.points[j].normal = glm::vec3(0.0f, 0.0f, 1.0f);
+					}
+					builder.addTriangle(tri, materials[(x + y) % 2]);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "Builder.h"
+#include "DIFBuilder/DIFBuilder.hpp"
+
+namespace DifBuilderLibTests
+{
+	// An unwelded interior laid out the way DIFBuilder builds one: a size by size grid of quads in the z = 0 plane,
+	// two triangle surfaces each with their own points, normal, plane and texgen. Every surface has a hull and
+	// sits in one solid leaf and one zone. A null surface and a portal, both on planes of their own, share the
+	// rest of the winding array, and the last row of surfaces has a lightmap.
+	DIF::Interior gridInterior(int size);
+
+	// The plane a reference with the 0x8000 flip flag resolves to, as normal and distance
+	glm::vec4 resolvePlane(const DIF::Interior &interior, U32 reference);
+
+	// Points of index[start, start + count)
+	std::vector<glm::vec3> windingPoints(const DIF::Interior &interior, U32 start, U32 count);
+
+	// Summed area of the surface windings, read as the zig zag strips the engine renders
+	float surfaceArea(const DIF::Interior &interior);
+
+	// CHECKs every index in the interior against the array it refers to
+	void checkInterior(const DIF::Interior &interior);
+
+	// Submits a size by size grid of quads in the z = 0 plane as triangles, alternating between two materials
+	void addGrid(DifBuilderLib::Builder &builder, int size);
+}
@@ -0,0 +1,56 @@
+#include "Interiors.h"
+#include "Layout.h"
+#include "Remap.h"
+#include "Surfaces.h"
+#include "Test.h"
+#include "Weld.h"
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+using namespace DifBuilderLibTests;
+
+namespace
+{
+	// Centroid and lightmap index of every surface, sorted, to compare across a reordering
+	std::vector<std::tuple<float, float, float, U32>> surfaceKeys(const DIF::Interior &interior)
+	{
+		std::vector<std::tuple<float, float, float, U32>> keys;
+		for (size_t i = 0; i < interior.surface.size(); i++)
+		{
+			const DIF::Interior::Surface &surface = interior.surface[i];
+			glm::vec3 centroid(0.0f);
+			for (U32 j = 0; j < surface.windingCount; j++)
+				centroid += interior.point[interior.index[surface.windingStart + j]];
+			centroid /= (float)surface.windingCount;
+			keys.emplace_back(centroid.x, centroid.y, centroid.z, (U32)interior.normalLMapIndex[i]);
+		}
+		std::sort(keys.begin(), keys.end());
+		return keys;
+	}
+}
+
+// The passes a full export runs, in order, leave every reference in range
+TEST(weld_merge_layout)
+{
+	const int size = 8;
+	DIF::Interior interior = gridInterior(size);
+	std::vector<glm::vec3> nullWinding = windingPoints(interior, interior.nullSurface[0].windingStart, interior.nullSurface[0].windingCount);
+	std::vector<glm::vec3> portalWinding = windingPoints(interior, interior.windingIndex[0].windingStart, interior.windingIndex[0].windingCount);
+
+	DifBuilderLib::weldInterior(interior, DifBuilderLib::WeldTolerances(), true);
+	DifBuilderLib::mergeSurfaces(interior);
+	checkInterior(interior);
+	std::vector<std::tuple<float, float, float, U32>> keys = surfaceKeys(interior);
+	size_t windings = interior.index.size();
+
+	DifBuilderLib::optimizeLayout(interior);
+	checkInterior(interior);
+
+	// Same surfaces with the same lightmaps, in another order
+	CHECK(surfaceKeys(interior) == keys);
+	CHECK(interior.index.size() == windings);
+	CHECK(std::fabs(surfaceArea(interior) - (float)(size * size)) < 1e-3f);
+	CHECK(windingPoints(interior, interior.nullSurface[0].windingStart, interior.nullSurface[0].windingCount) == nullWinding);
+	CHECK(windingPoints(interior, interior.windingIndex[0].windingStart, interior.windingIndex[0].windingCount) == portalWinding);
+}
@@ -0,0 +1,54 @@
+#include "DifBuilderLib.h"
+#include "Interiors.h"
+#include "Test.h"
+
+using namespace DifBuilderLibTests;
+
+namespace
+{
+	// Triangles extract_mesh writes for the interior, vertices wrote into loopVertices
+	int extractedTriangles(DIF::Interior &interior, std::vector<int> &loopVertices)
+	{
+		int vertexCount = 0;
+		int triangleCount = 0;
+		get_mesh_sizes(&interior, &vertexCount, &triangleCount);
+		CHECK(vertexCount == (int)interior.point.size());
+
+		std::vector<float> positions(vertexCount * 3);
+		loopVertices.assign(triangleCount * 3, -1);
+		std::vector<float> loopUVs(triangleCount * 6);
+		std::vector<int> polyMaterials(triangleCount);
+		std::vector<float> polyNormals(triangleCount * 3);
+		extract_mesh(&interior, positions.data(), loopVertices.data(), loopUVs.data(), polyMaterials.data(), polyNormals.data());
+		return triangleCount;
+	}
+}
+
+// Surfaces referring past the end of any array are counted by neither get_mesh_sizes nor extract_mesh, the rest are
+// extracted as before
+TEST(extract_mesh_bounds)
+{
+	DIF::Interior interior = gridInterior(2);
+	std::vector<int> loopVertices;
+	int triangles = extractedTriangles(interior, loopVertices);
+	CHECK(triangles == (int)interior.surface.size());
+
+	interior.surface[0].texGenIndex = (U32)interior.texGenEq.size();
+	interior.surface[1].planeIndex = (U16)interior.plane.size();
+	interior.surface[2].windingStart = (U32)interior.index.size() - 1;
+	interior.index[interior.surface[3].windingStart] = (U32)interior.point.size();
+	interior.plane[interior.surface[4].planeIndex].normalIndex = (U16)interior.normal.size();
+
+	CHECK(extractedTriangles(interior, loopVertices) == triangles - 5);
+	for (int vertex : loopVertices)
+		CHECK(vertex >= 0 && vertex < (int)interior.point.size());
+
+	std::vector<int> windingStarts(interior.surface.size());
+	std::vector<int> windingCounts(interior.surface.size());
+	std::vector<int> planeIndices(interior.surface.size());
+	std::vector<int> textureIndices(interior.surface.size());
+	std::vector<int> texGenIndices(interior.surface.size());
+	get_surfaces(&interior, windingStarts.data(), windingCounts.data(), planeIndices.data(), textureIndices.data(), texGenIndices.data());
+	for (size_t i = 0; i < windingCounts.size(); i++)
+		CHECK((windingCounts[i] == 0) == (i < 5));
+}
@@ -0,0 +1,72 @@
+#include "Interiors.h"
+#include "Partition.h"
+#include "Test.h"
+#include <algorithm>
+#include <memory>
+#include <tuple>
+
+using namespace DifBuilderLibTests;
+
+namespace
+{
+	typedef std::tuple<float, float, float, float, float, std::string> TriangleKey;
+
+	// Summed corners, summed UVs and material name of every triangle in builder, sorted
+	std::vector<TriangleKey> triangleKeys(const DifBuilderLib::Builder &builder)
+	{
+		std::vector<TriangleKey> keys;
+		bool read = builder.forEachPage(0, [&](const DifBuilderLib::TriangleStore &page, size_t first, size_t count)
+		{
+			for (size_t i = first; i < first + count; i++)
+			{
+				DIF::DIFBuilder::Triangle tri = page.triangle(i);
+				glm::vec3 corners = tri.points[0].vertex + tri.points[1].vertex + tri.points[2].vertex;
+				glm::vec2 uv = tri.points[0].uv + tri.points[1].uv + tri.points[2].uv;
+				keys.emplace_back(corners.x, corners.y, corners.z, uv.x, uv.y, builder.materials[page.materials[i]]);
+			}
+			return true;
+		});
+		CHECK(read);
+		std::sort(keys.begin(), keys.end());
+		return keys;
+	}
+
+	void checkPartition(DifBuilderLib::PartitionStrategy strategy, size_t spillThreshold)
+	{
+		// Large enough for the binned split to recurse on another thread
+		const int size = 130;
+		const int budget = 5000;
+		DifBuilderLib::Builder source;
+		source.spillThreshold = spillThreshold;
+		addGrid(source, size);
+		std::vector<TriangleKey> before = triangleKeys(source);
+		int expected = DifBuilderLib::partitionCount(source, budget);
+
+		std::vector<std::unique_ptr<DifBuilderLib::Builder>> owned;
+		for (DifBuilderLib::Builder *chunk : DifBuilderLib::partition(source, budget, strategy))
+			owned.emplace_back(chunk);
+		CHECK(source.triangleCount() == 0);
+		CHECK((int)owned.size() == expected);
+
+		std::vector<TriangleKey> after;
+		for (const std::unique_ptr<DifBuilderLib::Builder> &chunk : owned)
+		{
+			CHECK(chunk->triangleCount() > 0);
+			CHECK(chunk->triangleCount() <= (size_t)budget);
+			CHECK(chunk->spilled.empty() == (spillThreshold == 0));
+			std::vector<TriangleKey> keys = triangleKeys(*chunk);
+			after.insert(after.end(), keys.begin(), keys.end());
+		}
+		std::sort(after.begin(), after.end());
+		CHECK(after == before);
+	}
+}
+
+// Every triangle ends up in exactly one chunk, whether the source streams or not
+TEST(partition_keeps_triangles)
+{
+	checkPartition(DifBuilderLib::PARTITION_MEDIAN, 0);
+	checkPartition(DifBuilderLib::PARTITION_BINNED, 0);
+	checkPartition(DifBuilderLib::PARTITION_MEDIAN, 4096);
+	checkPartition(DifBuilderLib::PARTITION_BINNED, 4096);
+}
@@ -0,0 +1,253 @@
+#include "Reader.h"
+#include "Test.h"
+#include "Writer.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using namespace DifBuilderLibTests;
+
+namespace
+{
+	// Writes the on disk DIF layout field by field, as far as scanDif reads it
+	struct DifEncoder
+	{
+		std::vector<char> bytes;
+
+		void raw(const void *data, size_t size)
+		{
+			bytes.insert(bytes.end(), (const char *)data, (const char *)data + size);
+		}
+
+		void u8(U8 value)
+		{
+			raw(&value, sizeof(value));
+		}
+
+		void u16(U16 value)
+		{
+			raw(&value, sizeof(value));
+		}
+
+		void u32(U32 value)
+		{
+			raw(&value, sizeof(value));
+		}
+
+		void zeros(size_t count)
+		{
+			bytes.insert(bytes.end(), count, 0);
+		}
+
+		void chunk(const char *type, const char *data, U32 length)
+		{
+			U8 size[4] = {(U8)(length >> 24), (U8)(length >> 16), (U8)(length >> 8), (U8)length};
+			raw(size, 4);
+			raw(type, 4);
+			raw(data, length);
+			zeros(4);
+		}
+
+		// A chunk that holds the bytes of an IEND footer, to show the scan goes by chunk length
+		void png()
+		{
+			static const U8 Signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+			static const char Header[13] = {0, 0, 0, 1, 0, 0, 0, 1, 8, 0, 0, 0, 0};
+			static const char Data[12] = {'I', 'E', 'N', 'D', (char)0xAE, 0x42, 0x60, (char)0x82, 1, 2, 3, 4};
+			raw(Signature, sizeof(Signature));
+			chunk("IHDR", Header, sizeof(Header));
+			chunk("IDAT", Data, sizeof(Data));
+			chunk("IEND", NULL, 0);
+		}
+
+		// A version 0 interior with one triangle winding and two surfaces over it
+		DifBuilderLib::InteriorSpan interior(bool tgea, int lightMaps)
+		{
+			DifBuilderLib::InteriorSpan span;
+			span.begin = bytes.size();
+
+			u32(0);
+			zeros(4 + 4 + 24 + 16 + 1 + 4);
+			u32(1);
+			zeros(12);
+			u32(1);
+			u16(0);
+			zeros(4);
+			u32(3);
+			zeros(36);
+			u32(3);
+			zeros(3);
+			u32(1);
+			zeros(32);
+			u32(1);
+			zeros(6);
+			u32(1);
+			zeros(6);
+
+			u8(1);
+			u32(1);
+			u8(4);
+			raw("grid", 4);
+
+			// Windings flagged as 16 bit
+			u32(3 | 0x80000000);
+			u32(1);
+			for (U16 i = 0; i < 3; i++)
+				u16(i);
+			u32(0);
+			u32(1);
+			zeros(12);
+			u32(1);
+			u16(0);
+			u32(0);
+			u32(0);
+
+			u32(2);
+			for (int i = 0; i < 2; i++)
+			{
+				u32(0);
+				u8(3);
+				u16(0);
+				u16(0);
+				u32(0);
+				zeros(21 + 4);
+				if (tgea)
+					zeros(1);
+			}
+
+			u32(2);
+			zeros(2);
+			u32(2);
+			zeros(2);
+			u32(0);
+
+			span.lightMapBegin = bytes.size();
+			u32((U32)lightMaps);
+			for (int i = 0; i < lightMaps; i++)
+			{
+				png();
+				if (tgea)
+					png();
+				u8(1);
+			}
+			span.lightMapEnd = bytes.size();
+
+			u32(2 | 0x80000000);
+			u32(0);
+			zeros(4);
+			u32(0);
+			u32(0);
+
+			u32(0);
+			u32(5);
+			u32(0);
+			zeros(5);
+			u32(0);
+			u32(0);
+
+			u32(1);
+			zeros(52);
+			u32(0);
+			u32(3 | 0x80000000);
+			u32(0);
+			zeros(6);
+			u32(1);
+			zeros(2);
+			u32(0);
+			u32(1);
+			zeros(4);
+			u32(0);
+			u32(0);
+			u32(0);
+
+			zeros(256 * 8);
+			u32(0);
+			u32(0);
+
+			zeros(8 + 12);
+			u32(1);
+			zeros(8);
+
+			span.end = bytes.size();
+			return span;
+		}
+	};
+
+	bool sameSpan(const DifBuilderLib::InteriorSpan &a, const DifBuilderLib::InteriorSpan &b)
+	{
+		return a.begin == b.begin && a.lightMapBegin == b.lightMapBegin && a.lightMapEnd == b.lightMapEnd && a.end == b.end;
+	}
+
+	void checkScan(bool tgea)
+	{
+		DifEncoder encoder;
+		encoder.u32(44);
+		encoder.u8(0);
+		DifBuilderLib::DifLayout expected;
+		expected.interiorsBegin = encoder.bytes.size();
+		encoder.u32(2);
+		expected.interiors.push_back(encoder.interior(tgea, 2));
+		expected.interiors.push_back(encoder.interior(tgea, 0));
+		expected.subObjectsBegin = encoder.bytes.size();
+		encoder.u32(1);
+		expected.subObjects.push_back(encoder.interior(tgea, 1));
+		expected.end = encoder.bytes.size();
+
+		// Triggers, path followers and the rest are not scanned
+		encoder.zeros(4 * 6);
+
+		DifBuilderLib::DifLayout layout;
+		CHECK(DifBuilderLib::scanDif(encoder.bytes.data(), encoder.bytes.size(), layout));
+		CHECK(layout.interiorsBegin == expected.interiorsBegin);
+		CHECK(layout.subObjectsBegin == expected.subObjectsBegin);
+		CHECK(layout.end == expected.end);
+		CHECK(layout.interiors.size() == 2 && layout.subObjects.size() == 1);
+		for (size_t i = 0; i < layout.interiors.size() && i < 2; i++)
+			CHECK(sameSpan(layout.interiors[i], expected.interiors[i]));
+		if (!layout.subObjects.empty())
+			CHECK(sameSpan(layout.subObjects[0], expected.subObjects[0]));
+
+		// Cut off anywhere inside the interiors, the scan stops rather than reading past the end
+		for (size_t size = expected.interiorsBegin; size < expected.end; size += 97)
+			CHECK(!DifBuilderLib::scanDif(encoder.bytes.data(), size, layout));
+	}
+}
+
+// TGEA surfaces carry an extra byte, TGE ones are told apart by the second surface failing the TGEA checks
+TEST(scan_dif_sections)
+{
+	checkScan(true);
+	checkScan(false);
+
+	// An embedded preview bitmap is not followed
+	DifEncoder preview;
+	preview.u32(44);
+	preview.u8(1);
+	preview.zeros(4 * 8);
+	DifBuilderLib::DifLayout layout;
+	CHECK(!DifBuilderLib::scanDif(preview.bytes.data(), preview.bytes.size(), layout));
+}
+
+// A file the scan cannot follow is read whole and filtered after
+TEST(read_dif_sections_fallback)
+{
+	DIF::DIF dif;
+	dif.interior.resize(2);
+	dif.interior[0].lightMap.resize(1);
+	dif.subObject.resize(1);
+	std::vector<char> data;
+	CHECK(DifBuilderLib::serialize(dif, data));
+
+	const char *path = "read_dif_sections_fallback.dif";
+	{
+		std::ofstream file(path, std::ios::binary);
+		file.write(data.data(), (std::streamsize)data.size());
+	}
+
+	DIF::DIF read;
+	CHECK(DifBuilderLib::readDifSections(path, DifBuilderLib::DIF_SECTION_INTERIORS, read));
+	CHECK(read.interior.size() == 2);
+	CHECK(read.interior.size() == 2 && read.interior[0].lightMap.empty());
+	CHECK(read.subObject.empty());
+	std::remove(path);
+}
@@ -0,0 +1,74 @@
+#include "Interiors.h"
+#include "Reader.h"
+#include "Remap.h"
+#include "Surfaces.h"
+#include "Test.h"
+#include "Weld.h"
+#include "Writer.h"
+#include <cmath>
+
+using namespace DifBuilderLibTests;
+
+namespace
+{
+	size_t litSurfaces(const DIF::Interior &interior)
+	{
+		size_t lit = 0;
+		for (size_t i = 0; i < interior.surface.size(); i++)
+			lit += DifBuilderLib::hasLightMap(interior, i) ? 1 : 0;
+		return lit;
+	}
+}
+
+TEST(merge_surfaces)
+{
+	const int size = 8;
+	DIF::Interior interior = gridInterior(size);
+	size_t surfaces = interior.surface.size();
+	size_t lit = litSurfaces(interior);
+	std::vector<glm::vec3> nullWinding = windingPoints(interior, interior.nullSurface[0].windingStart, interior.nullSurface[0].windingCount);
+	std::vector<glm::vec3> portalWinding = windingPoints(interior, interior.windingIndex[0].windingStart, interior.windingIndex[0].windingCount);
+
+	DifBuilderLib::weldInterior(interior, DifBuilderLib::WeldTolerances());
+	DifBuilderLib::mergeSurfaces(interior);
+	checkInterior(interior);
+
+	// The unlit rows merge, the lit one is left as it was
+	CHECK(interior.surface.size() < surfaces);
+	CHECK(litSurfaces(interior) == lit);
+	CHECK(std::fabs(surfaceArea(interior) - (float)(size * size)) < 1e-3f);
+	for (const DIF::Interior::Surface &surface : interior.surface)
+		CHECK(surface.windingCount <= 32);
+
+	CHECK(windingPoints(interior, interior.nullSurface[0].windingStart, interior.nullSurface[0].windingCount) == nullWinding);
+	CHECK(windingPoints(interior, interior.windingIndex[0].windingStart, interior.windingIndex[0].windingCount) == portalWinding);
+}
+
+TEST(merge_surfaces_round_trip)
+{
+	DIF::DIF dif;
+	dif.interior.push_back(gridInterior(8));
+	DifBuilderLib::weldDif(dif, DifBuilderLib::WeldTolerances());
+	DifBuilderLib::mergeSurfaces(dif);
+	const DIF::Interior &merged = dif.interior[0];
+
+	std::vector<char> data;
+	CHECK(DifBuilderLib::serialize(dif, data));
+	DIF::DIF read;
+	CHECK(DifBuilderLib::readDifBuffer(data.data(), data.size(), read));
+	CHECK(read.interior.size() == 1);
+	if (read.interior.size() != 1)
+		return;
+
+	const DIF::Interior &interior = read.interior[0];
+	checkInterior(interior);
+	CHECK(interior.surface.size() == merged.surface.size());
+	CHECK(interior.index.size() == merged.index.size());
+	CHECK(interior.point.size() == merged.point.size());
+	CHECK(interior.nullSurface.size() == merged.nullSurface.size());
+	CHECK(interior.windingIndex.size() == merged.windingIndex.size());
+	CHECK(interior.normalLMapIndex.size() == merged.normalLMapIndex.size());
+	CHECK(interior.solidLeafSurface.size() == merged.solidLeafSurface.size());
+	CHECK(interior.hullSurfaceIndex.size() == merged.hullSurfaceIndex.size());
+	CHECK(interior.zoneSurface.size() == merged.zoneSurface.size());
+}
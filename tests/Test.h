@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+
+namespace DifBuilderLibTests
+{
+	struct TestCase
+	{
+		const char *name;
+		void (*run)();
+	};
+
+	std::vector<TestCase> &testCases();
+
+	// Prints the failed check and marks the running test as failed
+	void fail(const char *file, int line, const char *expression);
+
+	struct RegisterTest
+	{
+		RegisterTest(const char *name, void (*run)())
+		{
+			testCases().push_back({name, run});
+		}
+	};
+}
+
+// Defines a test, run by name from CTest
+#define TEST(name)                                                             \
+	static void name();                                                        \
+	static DifBuilderLibTests::RegisterTest name##Registration(#name, name); \
+	static void name()
+
+// Carries on after a failure, so one run reports every broken check
+#define CHECK(expression)                                                 \
+	do                                                                    \
+	{                                                                     \
+		if (!(expression))                                                \
+			DifBuilderLibTests::fail(__FILE__, __LINE__, #expression); \
+	} while (0)
@@ -0,0 +1,105 @@
+#include "Interiors.h"
+#include "Test.h"
+#include "Weld.h"
+#include <cmath>
+
+using namespace DifBuilderLibTests;
+
+namespace
+{
+	const U32 PlaneFlipFlag = 0x8000;
+
+	bool samePlane(const glm::vec4 &a, const glm::vec4 &b)
+	{
+		return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
+	}
+
+	// Every plane reference resolved, in a fixed order, so welds can be compared against the unwelded interior
+	std::vector<glm::vec4> planeReferences(const DIF::Interior &interior)
+	{
+		std::vector<glm::vec4> planes;
+		for (const DIF::Interior::Surface &surface : interior.surface)
+			planes.push_back(resolvePlane(interior, surface.planeIndex | (surface.planeFlipped ? PlaneFlipFlag : 0)));
+		for (const DIF::Interior::NullSurface &surface : interior.nullSurface)
+			planes.push_back(resolvePlane(interior, surface.planeIndex));
+		for (const DIF::Interior::Portal &portal : interior.portal)
+			planes.push_back(resolvePlane(interior, portal.planeIndex));
+		for (const DIF::Interior::BSPNode &node : interior.bspNode)
+			planes.push_back(resolvePlane(interior, node.planeIndex));
+		for (U16 index : interior.hullPlaneIndex)
+			planes.push_back(resolvePlane(interior, index));
+		for (U16 index : interior.polyListPlaneIndex)
+			planes.push_back(resolvePlane(interior, index));
+		return planes;
+	}
+
+	// UV of every surface winding point, in surface order
+	std::vector<glm::vec2> surfaceUVs(const DIF::Interior &interior)
+	{
+		std::vector<glm::vec2> uvs;
+		for (const DIF::Interior::Surface &surface : interior.surface)
+		{
+			const DIF::Interior::TexGenEq &texGen = interior.texGenEq[surface.texGenIndex];
+			for (const glm::vec3 &p : windingPoints(interior, surface.windingStart, surface.windingCount))
+			{
+				float u = texGen.planeX.x * p.x + texGen.planeX.y * p.y + texGen.planeX.z * p.z + texGen.planeX.d;
+				float v = texGen.planeY.x * p.x + texGen.planeY.y * p.y + texGen.planeY.z * p.z + texGen.planeY.d;
+				uvs.push_back(glm::vec2(u, v));
+			}
+		}
+		return uvs;
+	}
+
+	void checkWeld(bool mergeOpposite)
+	{
+		DIF::Interior interior = gridInterior(4);
+		std::vector<glm::vec4> before = planeReferences(interior);
+		size_t planes = interior.plane.size();
+
+		DifBuilderLib::weldInterior(interior, DifBuilderLib::WeldTolerances(), mergeOpposite);
+		checkInterior(interior);
+		CHECK(interior.plane.size() < planes);
+
+		std::vector<glm::vec4> after = planeReferences(interior);
+		CHECK(after.size() == before.size());
+		for (size_t i = 0; i < before.size() && i < after.size(); i++)
+			CHECK(samePlane(after[i], before[i]));
+	}
+}
+
+TEST(weld_plane_references)
+{
+	checkWeld(false);
+}
+
+// The null surface's downward plane merges with the grid's and is referred to flipped instead
+TEST(weld_opposite_plane_references)
+{
+	checkWeld(true);
+
+	DIF::Interior interior = gridInterior(4);
+	DifBuilderLib::weldInterior(interior, DifBuilderLib::WeldTolerances(), true);
+	CHECK((interior.nullSurface[0].planeIndex & ~PlaneFlipFlag) == interior.surface[0].planeIndex);
+}
+
+// Texgens differing only along the surface normal, as the builder's per triangle fit leaves them, merge by default
+// and every UV stays where it was
+TEST(weld_texgen_uvs)
+{
+	DIF::Interior interior = gridInterior(4);
+	for (size_t i = 0; i < interior.texGenEq.size(); i++)
+	{
+		interior.texGenEq[i].planeX.z = 0.25f * (float)i;
+		interior.texGenEq[i].planeY.z = -0.5f * (float)i;
+	}
+	std::vector<glm::vec2> before = surfaceUVs(interior);
+
+	DifBuilderLib::weldInterior(interior, DifBuilderLib::WeldTolerances());
+	checkInterior(interior);
+	CHECK(interior.texGenEq.size() == 1);
+
+	std::vector<glm::vec2> after = surfaceUVs(interior);
+	CHECK(after.size() == before.size());
+	for (size_t i = 0; i < before.size() && i < after.size(); i++)
+		CHECK(std::fabs(after[i].x - before[i].x) <= 1e-5f && std::fabs(after[i].y - before[i].y) <= 1e-5f);
+}
@@ -0,0 +1,47 @@
+#include "Test.h"
+#include <cstdio>
+#include <cstring>
+
+namespace DifBuilderLibTests
+{
+	namespace
+	{
+		int failures = 0;
+	}
+
+	std::vector<TestCase> &testCases()
+	{
+		static std::vector<TestCase> cases;
+		return cases;
+	}
+
+	void fail(const char *file, int line, const char *expression)
+	{
+		printf("%s:%d: CHECK(%s) failed\n", file, line, expression);
+		failures++;
+	}
+}
+
+// difbuilderlib_tests [name], runs the named test or all of them
+int main(int argc, char **argv)
+{
+	using namespace DifBuilderLibTests;
+
+	int run = 0;
+	for (const TestCase &test : testCases())
+	{
+		if (argc > 1 && strcmp(argv[1], test.name) != 0)
+			continue;
+		int before = failures;
+		test.run();
+		printf("%s: %s\n", test.name, failures == before ? "passed" : "FAILED");
+		run++;
+	}
+
+	if (run == 0)
+	{
+		printf("no test named %s\n", argc > 1 ? argv[1] : "");
+		return 1;
+	}
+	return failures == 0 ? 0 : 1;
+}
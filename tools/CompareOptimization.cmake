@@ -0,0 +1,192 @@
+# Converts a generated scene with two difbuild binaries, one linked against DifBuilder built with optimizations and one
+# without, and fails unless every dif they write is byte for byte the same. Run as
+# cmake -DDIFBUILD=<difbuild> -DOTHER_DIFBUILD=<difbuild> -DWORK_DIR=<dir> -P CompareOptimization.cmake
+
+if(NOT DIFBUILD OR NOT OTHER_DIFBUILD OR NOT WORK_DIR)
+	message(FATAL_ERROR "DIFBUILD, OTHER_DIFBUILD and WORK_DIR are required")
+endif()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+# Coordinates are generated in quarter units so they stay exact in the obj text
+function(quarters value out)
+	math(EXPR whole "${value} / 4")
+	math(EXPR part "${value} % 4")
+	if(part EQUAL 0)
+		set(${out} "${whole}" PARENT_SCOPE)
+	elseif(part EQUAL 1)
+		set(${out} "${whole}.25" PARENT_SCOPE)
+	elseif(part EQUAL 2)
+		set(${out} "${whole}.5" PARENT_SCOPE)
+	else()
+		set(${out} "${whole}.75" PARENT_SCOPE)
+	endif()
+endfunction()
+
+set(obj "")
+set(base 0)
+
+function(add_vertex x y z)
+	quarters(${x} vx)
+	quarters(${y} vy)
+	quarters(${z} vz)
+	set(obj "${obj}v ${vx} ${vy} ${vz}\n" PARENT_SCOPE)
+endfunction()
+
+# Faces take 1 based offsets from base, counter-clockwise seen from outside
+function(add_face)
+	set(line "f")
+	foreach(corner ${ARGN})
+		math(EXPR index "${base} + ${corner}")
+		set(line "${line} ${index}")
+	endforeach()
+	set(obj "${obj}${line}\n" PARENT_SCOPE)
+endfunction()
+
+macro(add_box x0 y0 z0 x1 y1 z1)
+	add_vertex(${x0} ${y0} ${z0})
+	add_vertex(${x1} ${y0} ${z0})
+	add_vertex(${x1} ${y1} ${z0})
+	add_vertex(${x0} ${y1} ${z0})
+	add_vertex(${x0} ${y0} ${z1})
+	add_vertex(${x1} ${y0} ${z1})
+	add_vertex(${x1} ${y1} ${z1})
+	add_vertex(${x0} ${y1} ${z1})
+	add_face(1 4 3 2)
+	add_face(5 6 7 8)
+	add_face(1 2 6 5)
+	add_face(3 4 8 7)
+	add_face(4 1 5 8)
+	add_face(2 3 7 6)
+	math(EXPR base "${base} + 8")
+endmacro()
+
+# Rises towards +x, for planes off the axes
+macro(add_ramp x0 y0 z0 x1 y1 z1)
+	add_vertex(${x0} ${y0} ${z0})
+	add_vertex(${x1} ${y0} ${z0})
+	add_vertex(${x1} ${y1} ${z0})
+	add_vertex(${x0} ${y1} ${z0})
+	add_vertex(${x1} ${y0} ${z1})
+	add_vertex(${x1} ${y1} ${z1})
+	add_face(1 4 3 2)
+	add_face(1 5 6 4)
+	add_face(2 3 6 5)
+	add_face(1 2 5)
+	add_face(4 6 3)
+	math(EXPR base "${base} + 6")
+endmacro()
+
+# A floor, then a grid of boxes and ramps of varying size on it in two materials
+set(obj "usemtl floor\n")
+add_box(-8 -8 -4 488 488 0)
+foreach(i RANGE 0 11)
+	foreach(j RANGE 0 11)
+		math(EXPR x0 "${i} * 40 + ${j} % 3")
+		math(EXPR y0 "${j} * 40 + ${i} % 4")
+		math(EXPR x1 "${x0} + 10 + (${i} * ${j}) % 17")
+		math(EXPR y1 "${y0} + 9 + (${i} + ${j}) % 13")
+		math(EXPR z1 "5 + (${i} * 7 + ${j} * 3) % 29")
+		math(EXPR kind "(${i} + ${j}) % 3")
+		if(kind EQUAL 0)
+			set(obj "${obj}usemtl ramp\n")
+			add_ramp(${x0} ${y0} 0 ${x1} ${y1} ${z1})
+		else()
+			set(obj "${obj}usemtl wall\n")
+			add_box(${x0} ${y0} 0 ${x1} ${y1} ${z1})
+		endif()
+	endforeach()
+endforeach()
+file(WRITE "${WORK_DIR}/scene.obj" "${obj}")
+
+# Each variant is converted into its own directory with these difbuild options
+set(variants default double layout merge split)
+set(default_options "")
+set(double_options --double)
+set(layout_options --flip --optimize-layout)
+set(merge_options --merge-surfaces --optimize-layout)
+set(split_options -t 300)
+
+# Offset of the first byte where two files differ, read a block at a time. Sets out to the shorter size if one
+# is a prefix of the other
+function(first_difference a b out)
+	file(SIZE "${a}" size_a)
+	file(SIZE "${b}" size_b)
+	set(size ${size_a})
+	if(size_b LESS size)
+		set(size ${size_b})
+	endif()
+	set(block 4096)
+	set(offset 0)
+	while(offset LESS size)
+		file(READ "${a}" hex_a OFFSET ${offset} LIMIT ${block} HEX)
+		file(READ "${b}" hex_b OFFSET ${offset} LIMIT ${block} HEX)
+		if(NOT hex_a STREQUAL hex_b)
+			string(LENGTH "${hex_a}" length)
+			set(i 0)
+			while(i LESS length)
+				string(SUBSTRING "${hex_a}" ${i} 2 byte_a)
+				string(SUBSTRING "${hex_b}" ${i} 2 byte_b)
+				if(NOT byte_a STREQUAL byte_b)
+					math(EXPR found "${offset} + ${i} / 2")
+					set(${out} ${found} PARENT_SCOPE)
+					return()
+				endif()
+				math(EXPR i "${i} + 2")
+			endwhile()
+		endif()
+		math(EXPR offset "${offset} + ${block}")
+	endwhile()
+	set(${out} ${size} PARENT_SCOPE)
+endfunction()
+
+set(failed 0)
+foreach(variant ${variants})
+	foreach(side reference other)
+		if(side STREQUAL "reference")
+			set(tool "${DIFBUILD}")
+		else()
+			set(tool "${OTHER_DIFBUILD}")
+		endif()
+		set(out "${WORK_DIR}/${variant}/${side}")
+		file(MAKE_DIRECTORY "${out}")
+		execute_process(COMMAND "${tool}" -j 1 -o "${out}" ${${variant}_options} "${WORK_DIR}/scene.obj" RESULT_VARIABLE result OUTPUT_QUIET)
+		if(NOT result EQUAL 0)
+			message(FATAL_ERROR "${variant}: ${tool} failed with ${result}")
+		endif()
+	endforeach()
+
+	file(GLOB reference_difs RELATIVE "${WORK_DIR}/${variant}/reference" "${WORK_DIR}/${variant}/reference/*.dif")
+	file(GLOB other_difs RELATIVE "${WORK_DIR}/${variant}/other" "${WORK_DIR}/${variant}/other/*.dif")
+	list(SORT reference_difs)
+	list(SORT other_difs)
+	if(NOT reference_difs)
+		message(SEND_ERROR "${variant}: no difs written")
+		set(failed 1)
+		continue()
+	endif()
+	if(NOT reference_difs STREQUAL other_difs)
+		message(SEND_ERROR "${variant}: wrote [${reference_difs}] and [${other_difs}]")
+		set(failed 1)
+		continue()
+	endif()
+	foreach(dif ${reference_difs})
+		execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files "${WORK_DIR}/${variant}/reference/${dif}" "${WORK_DIR}/${variant}/other/${dif}" RESULT_VARIABLE different)
+		if(different)
+			set(reference "${WORK_DIR}/${variant}/reference/${dif}")
+			set(other "${WORK_DIR}/${variant}/other/${dif}")
+			first_difference("${reference}" "${other}" offset)
+			file(SIZE "${reference}" reference_size)
+			file(SIZE "${other}" other_size)
+			message(SEND_ERROR "${variant}: ${dif} differs from byte ${offset} on, ${reference_size} bytes against ${other_size}")
+			set(failed 1)
+		endif()
+	endforeach()
+	list(LENGTH reference_difs count)
+	message(STATUS "${variant}: ${count} identical dif(s)")
+endforeach()
+
+if(failed)
+	message(FATAL_ERROR "The difs built with DifBuilder optimized and not optimized do not match")
+endif()
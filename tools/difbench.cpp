@@ -0,0 +1,351 @@
+// difbench: times submission, build, write and read back of synthetic scenes through the DifBuilderLib C API
+//
+// Prints one JSON object per scene and size to stdout, so runs can be diffed or collected by a script.
+//
+//   difbench [-s sizes] [-k kinds] [-t max triangles] [-j threads] [-r repeats]
+//
+// sizes is a comma separated list of triangle counts (default 1000,10000,100000,1000000), kinds a comma
+// separated subset of grid,sphere,materials,track.
+#include "DifBuilderLib.h"
+#include "Partition.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+	struct Scene
+	{
+		std::vector<std::string> materials;
+		std::vector<float> positions;
+		std::vector<float> uvs;
+		std::vector<float> normals;
+		std::vector<int> materialIndices;
+
+		void addQuad(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c, const glm::vec3 &d, int material)
+		{
+			addTriangle(a, b, c, material);
+			addTriangle(a, c, d, material);
+		}
+
+		void addTriangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c, int material)
+		{
+			glm::vec3 n = glm::cross(b - a, c - a);
+			float length = std::sqrt(glm::dot(n, n));
+			n = length > 0.0f ? n / length : glm::vec3(0.0f, 0.0f, 1.0f);
+			for (const glm::vec3 &p : {a, b, c})
+			{
+				positions.insert(positions.end(), {p.x, p.y, p.z});
+				uvs.insert(uvs.end(), {p.x * 0.25f, p.y * 0.25f});
+			}
+			normals.insert(normals.end(), {n.x, n.y, n.z});
+			materialIndices.push_back(material);
+		}
+
+		int triangleCount() const
+		{
+			return (int)materialIndices.size();
+		}
+	};
+
+	// Flat grid of unit quads
+	Scene makeGrid(int triangles)
+	{
+		Scene scene;
+		scene.materials.push_back("grid");
+		int side = std::max(1, (int)std::sqrt(triangles / 2.0));
+		for (int y = 0; y < side; y++)
+		{
+			for (int x = 0; x < side; x++)
+				scene.addQuad(glm::vec3(x, y, 0), glm::vec3(x, y + 1, 0), glm::vec3(x + 1, y + 1, 0), glm::vec3(x + 1, y, 0), 0);
+		}
+		return scene;
+	}
+
+	// UV sphere, every face has its own plane
+	Scene makeSphere(int triangles)
+	{
+		Scene scene;
+		scene.materials.push_back("sphere");
+		int rings = std::max(2, (int)std::sqrt(triangles / 4.0));
+		int segments = rings * 2;
+		const float pi = 3.14159265358979f;
+		const float radius = 64.0f;
+		auto at = [&](int ring, int segment) {
+			float theta = pi * ring / rings;
+			float phi = 2.0f * pi * segment / segments;
+			return glm::vec3(radius * std::sin(theta) * std::cos(phi), radius * std::sin(theta) * std::sin(phi), radius * std::cos(theta));
+		};
+		for (int r = 0; r < rings; r++)
+		{
+			for (int s = 0; s < segments; s++)
+				scene.addQuad(at(r, s), at(r + 1, s), at(r + 1, s + 1), at(r, s + 1), 0);
+		}
+		return scene;
+	}
+
+	// Scattered boxes with 64 materials
+	Scene makeMaterials(int triangles)
+	{
+		Scene scene;
+		for (int i = 0; i < 64; i++)
+			scene.materials.push_back("material" + std::to_string(i));
+
+		int boxes = std::max(1, triangles / 12);
+		int side = std::max(1, (int)std::cbrt((double)boxes));
+		for (int i = 0; i < boxes; i++)
+		{
+			glm::vec3 o((float)(i % side) * 3.0f, (float)((i / side) % side) * 3.0f, (float)(i / (side * side)) * 3.0f);
+			int m = i % 64;
+			glm::vec3 c[8];
+			for (int j = 0; j < 8; j++)
+				c[j] = o + glm::vec3((float)(j & 1), (float)((j >> 1) & 1), (float)((j >> 2) & 1));
+			scene.addQuad(c[0], c[2], c[3], c[1], m);
+			scene.addQuad(c[4], c[5], c[7], c[6], m);
+			scene.addQuad(c[0], c[1], c[5], c[4], m);
+			scene.addQuad(c[2], c[6], c[7], c[3], m);
+			scene.addQuad(c[0], c[4], c[6], c[2], m);
+			scene.addQuad(c[1], c[3], c[7], c[5], m);
+		}
+		return scene;
+	}
+
+	// Long winding ribbon track with walls, the common shape of a level
+	Scene makeTrack(int triangles)
+	{
+		Scene scene;
+		scene.materials.push_back("floor");
+		scene.materials.push_back("wall");
+		int sections = std::max(1, triangles / 6);
+		const float width = 8.0f;
+		const float height = 2.0f;
+		auto center = [&](int i) {
+			float t = i * 0.02f;
+			return glm::vec3(i * 2.0f, 40.0f * std::sin(t), 10.0f * std::sin(t * 0.37f));
+		};
+		for (int i = 0; i < sections; i++)
+		{
+			glm::vec3 a = center(i), b = center(i + 1);
+			glm::vec3 side(0.0f, width * 0.5f, 0.0f);
+			glm::vec3 up(0.0f, 0.0f, height);
+			scene.addQuad(a - side, b - side, b + side, a + side, 0);
+			scene.addTriangle(a - side, a - side + up, b - side, 1);
+			scene.addTriangle(a + side, b + side, a + side + up, 1);
+		}
+		return scene;
+	}
+
+	Scene makeScene(const std::string &kind, int triangles)
+	{
+		if (kind == "sphere")
+			return makeSphere(triangles);
+		if (kind == "materials")
+			return makeMaterials(triangles);
+		if (kind == "track")
+			return makeTrack(triangles);
+		return makeGrid(triangles);
+	}
+
+	// Reads straight out of a write_dif_to_buffer buffer
+	class MemoryBuf : public std::streambuf
+	{
+	public:
+		MemoryBuf(const char *data, size_t size)
+		{
+			char *begin = const_cast<char *>(data);
+			setg(begin, begin, begin + size);
+		}
+	};
+
+	unsigned long long peakResidentBytes()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return counters.PeakWorkingSetSize;
+		return 0;
+#else
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0)
+			return 0;
+#ifdef __APPLE__
+		return (unsigned long long)usage.ru_maxrss;
+#else
+		return (unsigned long long)usage.ru_maxrss * 1024;
+#endif
+#endif
+	}
+
+	std::vector<std::string> split(const std::string &str)
+	{
+		std::vector<std::string> out;
+		std::stringstream ss(str);
+		std::string item;
+		while (std::getline(ss, item, ','))
+		{
+			if (!item.empty())
+				out.push_back(item);
+		}
+		return out;
+	}
+
+	struct Timings
+	{
+		double submit = 0, partition = 0, build = 0, write = 0, read = 0;
+		unsigned long long bytes = 0, peakAllocated = 0;
+		int chunks = 0, planes = 0, bspNodes = 0, hulls = 0;
+
+		// From analyze_dif on the read back chunks, the collision estimate is their average
+		int bspMaxDepth = 0;
+		double collisionPlaneTests = 0;
+	};
+
+	bool run(const Scene &scene, int maxTriangles, int threads, Timings &timings)
+	{
+		DifBuilderLib::Stopwatch submitTime;
+		DifBuilderLib::Builder *source = new_difbuilder();
+		reserve_difbuilder(source, scene.triangleCount());
+		std::vector<int> ids;
+		for (const std::string &material : scene.materials)
+			ids.push_back(register_material(source, const_cast<char *>(material.c_str())));
+		std::vector<int> materialIds(scene.materialIndices.size());
+		for (size_t i = 0; i < materialIds.size(); i++)
+			materialIds[i] = ids[scene.materialIndices[i]];
+		add_triangles(source, const_cast<float *>(scene.positions.data()), const_cast<float *>(scene.uvs.data()), const_cast<float *>(scene.normals.data()), materialIds.data(), scene.triangleCount(), NULL);
+		timings.submit += submitTime.seconds();
+
+		DifBuilderLib::Stopwatch partitionTime;
+		std::vector<DifBuilderLib::Builder *> chunks(get_partition_count(source, maxTriangles));
+		partition_difbuilder(source, maxTriangles, DifBuilderLib::PARTITION_BINNED, chunks.data());
+		dispose_difbuilder(source);
+		timings.partition += partitionTime.seconds();
+		timings.chunks = (int)chunks.size();
+
+		DifBuilderLib::Stopwatch buildTime;
+		std::vector<DIF::DIF *> difs(chunks.size());
+		build_many(chunks.data(), (int)chunks.size(), difs.data(), threads);
+		timings.build += buildTime.seconds();
+
+		bool ok = true;
+		timings.planes = timings.bspNodes = timings.hulls = 0;
+		timings.bytes = 0;
+		timings.bspMaxDepth = 0;
+		timings.collisionPlaneTests = 0;
+		for (size_t i = 0; i < chunks.size(); i++)
+		{
+			DifBuilderLib::BuildStats stats;
+			get_build_stats(chunks[i], &stats);
+			timings.planes += stats.planes;
+			timings.bspNodes += stats.bspNodes;
+			timings.hulls += stats.convexHulls;
+			timings.peakAllocated = std::max(timings.peakAllocated, stats.peakAllocatedBytes);
+			dispose_difbuilder(chunks[i]);
+
+			if (difs[i] == NULL)
+			{
+				ok = false;
+				continue;
+			}
+
+			DifBuilderLib::Stopwatch writeTime;
+			std::vector<char> *buffer = write_dif_to_buffer(difs[i]);
+			timings.write += writeTime.seconds();
+			dispose_dif(difs[i]);
+			if (buffer == NULL)
+			{
+				ok = false;
+				continue;
+			}
+			timings.bytes += buffer->size();
+
+			DifBuilderLib::Stopwatch readTime;
+			MemoryBuf buf(get_buffer_data(buffer), buffer->size());
+			std::istream in(&buf);
+			DIF::DIF readBack;
+			DIF::Version ver;
+			bool readOk = readBack.read(in, ver);
+			timings.read += readTime.seconds();
+			dispose_buffer(buffer);
+			ok = readOk && ok;
+			if (!readOk)
+				continue;
+
+			DifBuilderLib::AnalysisReport report;
+			analyze_dif(&readBack, &report);
+			timings.bspMaxDepth = std::max(timings.bspMaxDepth, report.bspMaxDepth);
+			timings.collisionPlaneTests += report.collisionPlaneTestsPerQuery / chunks.size();
+		}
+		return ok;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	std::vector<std::string> sizes = {"1000", "10000", "100000", "1000000"};
+	std::vector<std::string> kinds = {"grid", "sphere", "materials", "track"};
+	int maxTriangles = 16000;
+	int threads = 0;
+	int repeats = 1;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "-s" && i + 1 < argc)
+			sizes = split(argv[++i]);
+		else if (arg == "-k" && i + 1 < argc)
+			kinds = split(argv[++i]);
+		else if (arg == "-t" && i + 1 < argc)
+			maxTriangles = atoi(argv[++i]);
+		else if (arg == "-j" && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else if (arg == "-r" && i + 1 < argc)
+			repeats = std::max(1, atoi(argv[++i]));
+		else
+		{
+			fprintf(stderr, "usage: difbench [-s sizes] [-k grid,sphere,materials,track] [-t max triangles] [-j threads] [-r repeats]\n");
+			return 2;
+		}
+	}
+
+	bool ok = true;
+	for (const std::string &kind : kinds)
+	{
+		for (const std::string &size : sizes)
+		{
+			Scene scene = makeScene(kind, atoi(size.c_str()));
+			Timings timings;
+			bool runOk = true;
+			for (int r = 0; r < repeats; r++)
+				runOk = run(scene, maxTriangles, threads, timings) && runOk;
+			ok = ok && runOk;
+
+			double n = (double)scene.triangleCount();
+			double build = timings.build / repeats;
+			printf("{\"scene\":\"%s\",\"triangles\":%d,\"chunks\":%d,\"ok\":%s,"
+				   "\"submit_s\":%.6f,\"partition_s\":%.6f,\"build_s\":%.6f,\"write_s\":%.6f,\"read_s\":%.6f,"
+				   "\"build_tris_per_s\":%.1f,\"bytes\":%llu,\"planes\":%d,\"bsp_nodes\":%d,\"hulls\":%d,"
+				   "\"bsp_max_depth\":%d,\"collision_plane_tests\":%.2f,"
+				   "\"peak_allocated_bytes\":%llu,\"peak_rss_bytes\":%llu}\n",
+				   kind.c_str(), scene.triangleCount(), timings.chunks, runOk ? "true" : "false",
+				   timings.submit / repeats, timings.partition / repeats, build, timings.write / repeats, timings.read / repeats,
+				   build > 0.0 ? n / build : 0.0, timings.bytes, timings.planes, timings.bspNodes, timings.hulls,
+				   timings.bspMaxDepth, timings.collisionPlaneTests,
+				   timings.peakAllocated, peakResidentBytes());
+			fflush(stdout);
+		}
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,569 @@
+// difbuild: headless batch conversion of triangle soups into MBG DIFs through DifBuilderLib
+//
+// Inputs are Wavefront OBJ files or binary triangle soups (.tris, see readSoup). Next to each input an
+// optional sidecar named <input>.entities adds game entities and pathed interiors:
+//
+//   entity <gameClass> <datablock> <x> <y> <z> [key=value ...]
+//   pathed <mesh file> <initialPathPosition>
+//   marker <x> <y> <z> <msToNext>
+//   end
+//
+// Mesh files of pathed interiors are resolved relative to the sidecar.
+#include "DifBuilderLib.h"
+#include "Parallel.h"
+#include "Partition.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// With --stream, triangles held in memory before they move to the spill file
+	const int StreamSpillTriangles = 65536;
+
+	struct Options
+	{
+		std::string outputDir;
+		std::string cacheDir;
+		int jobs = 0;
+		// Starting budget, 0 takes it from the format limits like the exporter. Chunks crossing a limit are split further
+		int maxTriangles = 0;
+		bool flip = false;
+		bool doubleSided = false;
+		bool optimizeLayout = false;
+		bool mergeSurfaces = false;
+		bool stream = false;
+	};
+
+	// Flat add_triangles buffers for one mesh
+	struct Mesh
+	{
+		std::vector<std::string> materials;
+		std::vector<float> positions;
+		std::vector<float> uvs;
+		std::vector<float> normals;
+		std::vector<int> materialIndices;
+
+		void addTriangle(const glm::vec3 *p, const glm::vec2 *uv, const glm::vec3 &n, int material)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				positions.insert(positions.end(), {p[i].x, p[i].y, p[i].z});
+				uvs.insert(uvs.end(), {uv[i].x, uv[i].y});
+			}
+			normals.insert(normals.end(), {n.x, n.y, n.z});
+			materialIndices.push_back(material);
+		}
+	};
+
+	struct Entity
+	{
+		std::string gameClass;
+		std::string datablock;
+		glm::vec3 position;
+		DIF::Dictionary properties;
+	};
+
+	struct PathedInterior
+	{
+		std::string meshPath;
+		int initialPathPosition = 0;
+		std::vector<std::pair<glm::vec3, int>> markers;
+	};
+
+	std::mutex logMutex;
+
+	void log(const char *format, const std::string &a, const std::string &b = std::string())
+	{
+		std::lock_guard<std::mutex> lock(logMutex);
+		fprintf(stderr, format, a.c_str(), b.c_str());
+	}
+
+	bool endsWith(const std::string &str, const std::string &suffix)
+	{
+		return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+	}
+
+	std::string directoryOf(const std::string &path)
+	{
+		size_t slash = path.find_last_of("/\\");
+		return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+	}
+
+	std::string stemOf(const std::string &path)
+	{
+		size_t slash = path.find_last_of("/\\");
+		std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+		size_t dot = name.find_last_of('.');
+		return dot == std::string::npos ? name : name.substr(0, dot);
+	}
+
+	int materialIndex(Mesh &mesh, const std::string &name)
+	{
+		for (size_t i = 0; i < mesh.materials.size(); i++)
+		{
+			if (mesh.materials[i] == name)
+				return (int)i;
+		}
+		mesh.materials.push_back(name);
+		return (int)mesh.materials.size() - 1;
+	}
+
+	// OBJ faces are counter-clockwise like Blender's, so they are reversed the same way the exporter does
+	bool readObj(const std::string &path, Mesh &mesh)
+	{
+		std::ifstream in(path);
+		if (!in.is_open())
+			return false;
+
+		std::vector<glm::vec3> vertices;
+		std::vector<glm::vec2> texCoords;
+		std::vector<glm::vec3> normals;
+		int material = materialIndex(mesh, "NULL");
+
+		std::string line;
+		while (std::getline(in, line))
+		{
+			std::istringstream ss(line);
+			std::string type;
+			ss >> type;
+
+			if (type == "v")
+			{
+				glm::vec3 v;
+				ss >> v.x >> v.y >> v.z;
+				vertices.push_back(v);
+			}
+			else if (type == "vt")
+			{
+				glm::vec2 vt;
+				ss >> vt.x >> vt.y;
+				texCoords.push_back(vt);
+			}
+			else if (type == "vn")
+			{
+				glm::vec3 vn;
+				ss >> vn.x >> vn.y >> vn.z;
+				normals.push_back(vn);
+			}
+			else if (type == "usemtl")
+			{
+				std::string name;
+				ss >> name;
+				material = materialIndex(mesh, name);
+			}
+			else if (type == "f")
+			{
+				std::vector<glm::vec3> p;
+				std::vector<glm::vec2> uv;
+				std::vector<int> n;
+				std::string corner;
+				while (ss >> corner)
+				{
+					int indices[3] = {0, 0, 0};
+					const char *c = corner.c_str();
+					for (int i = 0; i < 3 && *c != '\0'; i++)
+					{
+						indices[i] = (int)strtol(c, const_cast<char **>(&c), 10);
+						if (*c == '/')
+							c++;
+					}
+
+					int vi = indices[0] < 0 ? (int)vertices.size() + indices[0] : indices[0] - 1;
+					int ti = indices[1] < 0 ? (int)texCoords.size() + indices[1] : indices[1] - 1;
+					int ni = indices[2] < 0 ? (int)normals.size() + indices[2] : indices[2] - 1;
+					if (vi < 0 || vi >= (int)vertices.size())
+						return false;
+
+					p.push_back(vertices[vi]);
+					uv.push_back(ti >= 0 && ti < (int)texCoords.size() ? texCoords[ti] : glm::vec2(0.0f, 0.0f));
+					n.push_back(ni >= 0 && ni < (int)normals.size() ? ni : -1);
+				}
+
+				for (size_t i = 1; i + 1 < p.size(); i++)
+				{
+					glm::vec3 tp[3] = {p[i + 1], p[i], p[0]};
+					glm::vec2 tuv[3] = {uv[i + 1], uv[i], uv[0]};
+					glm::vec3 normal = n[0] >= 0 ? normals[n[0]] : glm::normalize(glm::cross(p[i] - p[0], p[i + 1] - p[0]));
+					mesh.addTriangle(tp, tuv, normal, material);
+				}
+			}
+		}
+		return true;
+	}
+
+	template <typename T>
+	bool readValue(std::ifstream &in, T &value)
+	{
+		return (bool)in.read(reinterpret_cast<char *>(&value), sizeof(T));
+	}
+
+	// Binary triangle soup, little endian:
+	//   char[4] "DIFS", u32 version (1)
+	//   u32 materialCount, then per material: u32 length, char[length] name
+	//   u32 triangleCount, then per triangle: f32[9] positions, f32[6] uvs, f32[3] normal, i32 material
+	// Triangles are stored in the winding DIFBuilder expects, like add_triangles takes them.
+	bool readSoup(const std::string &path, Mesh &mesh)
+	{
+		std::ifstream in(path, std::ios::in | std::ios::binary);
+		if (!in.is_open())
+			return false;
+
+		char magic[4];
+		unsigned int version;
+		if (!in.read(magic, 4) || memcmp(magic, "DIFS", 4) != 0 || !readValue(in, version) || version != 1)
+			return false;
+
+		unsigned int materialCount;
+		if (!readValue(in, materialCount))
+			return false;
+		for (unsigned int i = 0; i < materialCount; i++)
+		{
+			unsigned int length;
+			if (!readValue(in, length))
+				return false;
+			std::string name(length, '\0');
+			if (!in.read(&name[0], length))
+				return false;
+			mesh.materials.push_back(name);
+		}
+
+		unsigned int triangleCount;
+		if (!readValue(in, triangleCount))
+			return false;
+		mesh.positions.resize((size_t)triangleCount * 9);
+		mesh.uvs.resize((size_t)triangleCount * 6);
+		mesh.normals.resize((size_t)triangleCount * 3);
+		mesh.materialIndices.resize(triangleCount);
+		for (unsigned int i = 0; i < triangleCount; i++)
+		{
+			if (!in.read(reinterpret_cast<char *>(&mesh.positions[i * 9]), sizeof(float) * 9) ||
+				!in.read(reinterpret_cast<char *>(&mesh.uvs[i * 6]), sizeof(float) * 6) ||
+				!in.read(reinterpret_cast<char *>(&mesh.normals[i * 3]), sizeof(float) * 3) ||
+				!readValue(in, mesh.materialIndices[i]))
+				return false;
+		}
+		return true;
+	}
+
+	bool readMesh(const std::string &path, Mesh &mesh)
+	{
+		return endsWith(path, ".obj") ? readObj(path, mesh) : readSoup(path, mesh);
+	}
+
+	bool readSidecar(const std::string &path, std::vector<Entity> &entities, std::vector<PathedInterior> &pathed)
+	{
+		std::ifstream in(path);
+		if (!in.is_open())
+			return true;
+
+		std::string line;
+		PathedInterior *current = NULL;
+		while (std::getline(in, line))
+		{
+			std::istringstream ss(line);
+			std::string type;
+			if (!(ss >> type) || type[0] == '#')
+				continue;
+
+			if (type == "entity")
+			{
+				Entity entity;
+				ss >> entity.gameClass >> entity.datablock >> entity.position.x >> entity.position.y >> entity.position.z;
+				std::string kvp;
+				while (ss >> kvp)
+				{
+					size_t eq = kvp.find('=');
+					if (eq != std::string::npos)
+						entity.properties.push_back(std::make_pair(kvp.substr(0, eq), kvp.substr(eq + 1)));
+				}
+				entities.push_back(entity);
+			}
+			else if (type == "pathed")
+			{
+				pathed.push_back(PathedInterior());
+				current = &pathed.back();
+				ss >> current->meshPath >> current->initialPathPosition;
+				current->meshPath = directoryOf(path) + current->meshPath;
+			}
+			else if (type == "marker" && current != NULL)
+			{
+				glm::vec3 pos;
+				int msToNext = 0;
+				ss >> pos.x >> pos.y >> pos.z >> msToNext;
+				current->markers.push_back(std::make_pair(pos, msToNext));
+			}
+			else if (type == "end")
+			{
+				current = NULL;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Submits mesh with the exporter's flip and double face modes
+	void submit(DifBuilderLib::Builder *builder, Mesh &mesh, const Options &options)
+	{
+		std::vector<int> ids;
+		for (const std::string &material : mesh.materials)
+			ids.push_back(register_material(builder, const_cast<char *>(material.c_str())));
+
+		size_t count = mesh.materialIndices.size();
+		std::vector<int> materialIds(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			int material = mesh.materialIndices[i];
+			materialIds[i] = material >= 0 && material < (int)ids.size() ? ids[material] : -1;
+		}
+
+		int flags = (options.flip ? DifBuilderLib::FACE_FLIP : 0) | (options.doubleSided ? DifBuilderLib::FACE_DOUBLE_SIDED : 0);
+		set_face_mode(builder, flags);
+		add_triangles(builder, mesh.positions.data(), mesh.uvs.data(), mesh.normals.data(), materialIds.data(), (int)count, NULL);
+	}
+
+	bool convert(const std::string &input, const Options &options)
+	{
+		Mesh mesh;
+		if (!readMesh(input, mesh))
+		{
+			log("%s: could not read mesh\n", input);
+			return false;
+		}
+
+		std::vector<Entity> entities;
+		std::vector<PathedInterior> pathed;
+		if (!readSidecar(input + ".entities", entities, pathed))
+		{
+			log("%s: could not parse %s\n", input, input + ".entities");
+			return false;
+		}
+
+		DifBuilderLib::Builder *source = new_difbuilder();
+		source->cacheDir = options.cacheDir;
+		source->optimizeLayout = options.optimizeLayout;
+		source->mergeSurfaces = options.mergeSurfaces;
+		if (options.stream)
+			set_streaming(source, NULL, StreamSpillTriangles);
+		submit(source, mesh, options);
+		mesh = Mesh();
+
+		if (get_triangle_count(source) == 0)
+		{
+			dispose_difbuilder(source);
+			log("%s: no triangles\n", input);
+			return false;
+		}
+
+		int startBudget = options.maxTriangles > 0 ? options.maxTriangles : get_start_budget();
+		std::vector<DifBuilderLib::Builder *> chunks(get_partition_count(source, startBudget));
+		partition_difbuilder(source, startBudget, DifBuilderLib::PARTITION_BINNED, chunks.data());
+		dispose_difbuilder(source);
+
+		bool ok = true;
+		// Movers sharing a mesh file are built once and end up sharing one sub object
+		std::map<std::string, DIF::DIF *> moverDifs;
+		for (const PathedInterior &mover : pathed)
+		{
+			DIF::DIF *&moverDif = moverDifs[mover.meshPath];
+			if (moverDif == NULL)
+			{
+				Mesh moverMesh;
+				if (!readMesh(mover.meshPath, moverMesh))
+				{
+					log("%s: could not read pathed interior %s\n", input, mover.meshPath);
+					ok = false;
+					continue;
+				}
+
+				DifBuilderLib::Builder *moverBuilder = new_difbuilder();
+				moverBuilder->cacheDir = options.cacheDir;
+				moverBuilder->optimizeLayout = options.optimizeLayout;
+				moverBuilder->mergeSurfaces = options.mergeSurfaces;
+				submit(moverBuilder, moverMesh, options);
+				moverDif = build(moverBuilder);
+				dispose_difbuilder(moverBuilder);
+				if (moverDif == NULL)
+				{
+					log("%s: could not build pathed interior %s\n", input, mover.meshPath);
+					ok = false;
+					continue;
+				}
+			}
+
+			std::vector<DIF::DIFBuilder::Marker> *markers = new_marker_list();
+			for (const std::pair<glm::vec3, int> &marker : mover.markers)
+			{
+				float pos[3] = {marker.first.x, marker.first.y, marker.first.z};
+				push_marker(markers, pos, marker.second, mover.initialPathPosition);
+			}
+			add_pathed_interior(chunks[0], moverDif, markers);
+			dispose_marker_list(markers);
+		}
+		for (const auto &moverDif : moverDifs)
+			dispose_dif(moverDif.second);
+
+		// Chunks whose DIF crosses a format limit are split further and built again
+		std::vector<DIF::DIF *> difs(chunks.size(), NULL);
+		std::vector<bool> built(chunks.size(), false);
+		for (bool split = true; split;)
+		{
+			std::vector<DifBuilderLib::Builder *> pending;
+			for (size_t i = 0; i < chunks.size(); i++)
+			{
+				if (!built[i])
+					pending.push_back(chunks[i]);
+			}
+			std::vector<DIF::DIF *> pendingDifs(pending.size());
+			build_many(pending.data(), (int)pending.size(), pendingDifs.data(), 1);
+
+			split = false;
+			std::vector<DifBuilderLib::Builder *> nextChunks;
+			std::vector<DIF::DIF *> nextDifs;
+			std::vector<bool> nextBuilt;
+			size_t next = 0;
+			for (size_t i = 0; i < chunks.size(); i++)
+			{
+				if (!built[i])
+					difs[i] = pendingDifs[next++];
+
+				int budget = difs[i] == NULL ? 0 : get_split_budget(chunks[i], difs[i]);
+				if (budget == 0)
+				{
+					nextChunks.push_back(chunks[i]);
+					nextDifs.push_back(difs[i]);
+					nextBuilt.push_back(true);
+					continue;
+				}
+
+				std::vector<DifBuilderLib::Builder *> parts(get_partition_count(chunks[i], budget));
+				partition_difbuilder(chunks[i], budget, DifBuilderLib::PARTITION_BINNED, parts.data());
+				dispose_difbuilder(chunks[i]);
+				dispose_dif(difs[i]);
+				for (DifBuilderLib::Builder *part : parts)
+				{
+					nextChunks.push_back(part);
+					nextDifs.push_back(NULL);
+					nextBuilt.push_back(false);
+				}
+				split = true;
+			}
+			chunks.swap(nextChunks);
+			difs.swap(nextDifs);
+			built.swap(nextBuilt);
+		}
+
+		for (size_t i = 0; i < chunks.size(); i++)
+		{
+			dispose_difbuilder(chunks[i]);
+			if (difs[i] == NULL)
+			{
+				log("%s: build failed\n", input);
+				ok = false;
+				continue;
+			}
+
+			if (i == 0)
+			{
+				for (Entity &entity : entities)
+				{
+					float pos[3] = {entity.position.x, entity.position.y, entity.position.z};
+					add_game_entity(difs[i], const_cast<char *>(entity.gameClass.c_str()), const_cast<char *>(entity.datablock.c_str()), pos, &entity.properties);
+				}
+			}
+
+			std::string outPath = (options.outputDir.empty() ? directoryOf(input) : options.outputDir + "/") + stemOf(input) + std::to_string(i) + ".dif";
+			if (!write_dif(difs[i], const_cast<char *>(outPath.c_str())))
+			{
+				log("%s: could not write %s\n", input, outPath);
+				ok = false;
+			}
+			dispose_dif(difs[i]);
+		}
+
+		if (ok)
+			log("%s: wrote %s\n", input, std::to_string(chunks.size()) + " dif(s)");
+		return ok;
+	}
+
+	void usage()
+	{
+		fprintf(stderr,
+				"usage: difbuild [options] <input.obj|input.tris>...\n"
+				"  -o <dir>             output directory (default: next to each input)\n"
+				"  -j <jobs>            inputs converted in parallel (default: all cores)\n"
+				"  -t <max triangles>   starting triangle budget per dif, split further on format limits (default: from the format limits)\n"
+				"  -c <dir>             reuse difs built from unchanged inputs from this cache directory\n"
+				"  --flip               flip faces\n"
+				"  --double             make faces double sided\n"
+				"  --optimize-layout    reorder surfaces, windings and points for locality\n"
+				"  --merge-surfaces     merge adjacent coplanar triangles into larger surfaces\n"
+				"  --stream             keep submitted triangles in a temporary file instead of memory\n");
+	}
+}
+
+int main(int argc, char **argv)
+{
+	Options options;
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "-o" && i + 1 < argc)
+			options.outputDir = argv[++i];
+		else if (arg == "-j" && i + 1 < argc)
+			options.jobs = atoi(argv[++i]);
+		else if (arg == "-t" && i + 1 < argc)
+			options.maxTriangles = atoi(argv[++i]);
+		else if (arg == "-c" && i + 1 < argc)
+			options.cacheDir = argv[++i];
+		else if (arg == "--flip")
+			options.flip = true;
+		else if (arg == "--double")
+			options.doubleSided = true;
+		else if (arg == "--optimize-layout")
+			options.optimizeLayout = true;
+		else if (arg == "--merge-surfaces")
+			options.mergeSurfaces = true;
+		else if (arg == "--stream")
+			options.stream = true;
+		else if (arg == "-h" || arg == "--help")
+		{
+			usage();
+			return 0;
+		}
+		else if (!arg.empty() && arg[0] == '-')
+		{
+			usage();
+			return 2;
+		}
+		else
+			inputs.push_back(arg);
+	}
+
+	if (inputs.empty())
+	{
+		usage();
+		return 2;
+	}
+
+	std::vector<char> results(inputs.size(), 0);
+	DifBuilderLib::parallelFor((int)inputs.size(), options.jobs, [&](int i) {
+		results[i] = convert(inputs[i], options) ? 1 : 0;
+	});
+
+	int failed = 0;
+	for (char result : results)
+		failed += result ? 0 : 1;
+	return failed == 0 ? 0 : 1;
+}